@@ -27,6 +27,7 @@
 #include <KMessageBox>
 
 #include <QBuffer>
+#include <QCryptographicHash>
 #include <QDataStream>
 #include <QTreeWidget>
 #include <KSharedConfig>
@@ -37,6 +38,7 @@
 #include <QPushButton>
 #include <QVBoxLayout>
 #include <QFileDialog>
+#include <QPixmapCache>
 
 AttachPropertyDialog::AttachPropertyDialog(QWidget *parent)
     : QDialog(parent)
@@ -236,15 +238,25 @@ QPixmap AttachPropertyDialog::loadRenderingPixmap(KTNEFPropertySet *pSet, const
         rendBuffer.close();
 
         if (type == 1 && w > 0 && h > 0) {
+            QByteArray qb = wmf.toByteArray();
+            // The list view and the property dialog render the same attachments
+            // again and again: keep the result in the shared pixmap cache
+            const QString cacheKey = QStringLiteral("ktnef-wmf-%1-%2x%3-%4")
+                                     .arg(QString::fromLatin1(QCryptographicHash::hash(qb, QCryptographicHash::Sha1).toHex()))
+                                     .arg(w).arg(h).arg(bgColor.rgba());
+            if (QPixmapCache::find(cacheKey, &pix)) {
+                return pix;
+            }
+
             // Load WMF data
             QWinMetaFile wmfLoader;
-            QByteArray qb = wmf.toByteArray();
             QBuffer wmfBuffer(&qb);
             wmfBuffer.open(QIODevice::ReadOnly);
             if (wmfLoader.load(wmfBuffer)) {
-                pix.scaled(w, h, Qt::KeepAspectRatio);
+                pix = QPixmap(w, h);
                 pix.fill(bgColor);
                 wmfLoader.paint(&pix);
+                QPixmapCache::insert(cacheKey, pix);
             }
             wmfBuffer.close();
         }
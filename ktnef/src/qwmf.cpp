@@ -29,6 +29,7 @@
 #include <QBuffer>
 #include <QFile>
 #include <QPolygon>
+#include <QtEndian>
 
 #include "ktnef_debug.h"
 
@@ -40,20 +41,6 @@ bool qwmfDebug = false;
 
 #define QWMF_DEBUG  0
 
-class WmfCmd
-{
-public:
-    ~WmfCmd()
-    {
-        delete next;
-    }
-
-    WmfCmd *next;
-    unsigned short funcIndex;
-    long numParm;
-    short *parm;
-};
-
 class WinObjHandle
 {
 public:
@@ -128,11 +115,13 @@ void WinObjFontHandle::apply(QPainter &p)
 
 #define MAX_OBJHANDLE 64
 
+// Larger bitmaps are scaled by the painter
+static const int s_maximumScaledDibSize = 4096;
+
 //-----------------------------------------------------------------------------
 QWinMetaFile::QWinMetaFile()
 {
     mValid = false;
-    mFirstCmd = nullptr;
     mObjHandleTab = nullptr;
     mDpi = 1000;
 }
@@ -140,7 +129,6 @@ QWinMetaFile::QWinMetaFile()
 //-----------------------------------------------------------------------------
 QWinMetaFile::~QWinMetaFile()
 {
-    delete mFirstCmd;
     if (mObjHandleTab) {
         delete[] mObjHandleTab;
     }
@@ -177,18 +165,15 @@ bool QWinMetaFile::load(QBuffer &buffer)
     WmfMetaHeader header;
     WmfPlaceableHeader pheader;
     WORD checksum;
-    int filePos, idx, i;
-    WmfCmd *cmd, *last;
+    int filePos;
     DWORD rdSize;
     WORD rdFunc;
 
     mTextAlign = 0;
     mRotation = 0;
     mTextColor = Qt::black;
-    if (mFirstCmd) {
-        delete mFirstCmd;
-    }
-    mFirstCmd = nullptr;
+    mCmds.clear();
+    mParms.clear();
 
     st.setDevice(&buffer);
     st.setByteOrder(QDataStream::LittleEndian);   // Great, I love Qt !
@@ -288,43 +273,45 @@ bool QWinMetaFile::load(QBuffer &buffer)
     mValid = ((header.mtHeaderSize == 9) && (header.mtNoParameters == 0)) || mIsEnhanced || mIsPlaceable;
     if (mValid) {
         //----- Read Metafile Records
-        last = nullptr;
+        // The parameters of all the records are stored in one array, read
+        // from the buffer directly instead of word by word
+        const QByteArray data = buffer.data();
+        const char *const begin = data.constData();
+        const qint64 size = data.size();
+        qint64 pos = buffer.pos();
+        mParms.reserve((size - pos) / sizeof(WORD));
         rdFunc = -1;
-        while (!st.atEnd() && (rdFunc != 0)) {
-            st >> rdSize;
-            st >> rdFunc;
-            idx = findFunc(rdFunc);
-            rdSize -= 3;
-
-            cmd = new WmfCmd;
-            cmd->next = nullptr;
-            if (last) {
-                last->next = cmd;
-            } else {
-                mFirstCmd = cmd;
+        while (pos < size && (rdFunc != 0)) {
+            if (size - pos < static_cast<qint64>(sizeof(DWORD) + sizeof(WORD))) {
+                qCDebug(KTNEFAPPS_LOG) << "WMF : file truncated !";
+                return false;
             }
-
-            cmd->funcIndex = idx;
-            cmd->numParm = rdSize;
-            cmd->parm = new WORD[ rdSize ];
-            last = cmd;
-
-            for (i = 0; i < rdSize && !st.atEnd(); ++i) {
-                st >> cmd->parm[ i ];
+            rdSize = qFromLittleEndian<qint32>(begin + pos);
+            rdFunc = qFromLittleEndian<qint16>(begin + pos + sizeof(DWORD));
+            pos += sizeof(DWORD) + sizeof(WORD);
+            rdSize -= 3;
+            if (rdSize < 0 || rdSize > (size - pos) / static_cast<qint64>(sizeof(WORD))) {
+                qCDebug(KTNEFAPPS_LOG) << "WMF : file truncated !";
+                return false;
             }
 
-            if (rdFunc == 0x020B) {           // SETWINDOWORG: dimensions
-                mBBox.setLeft(cmd->parm[ 1 ]);
-                mBBox.setTop(cmd->parm[ 0 ]);
-            }
-            if (rdFunc == 0x020C) {           // SETWINDOWEXT: dimensions
-                mBBox.setWidth(cmd->parm[ 1 ]);
-                mBBox.setHeight(cmd->parm[ 0 ]);
+            WmfCmd cmd;
+            cmd.funcIndex = findFunc(rdFunc);
+            cmd.numParm = rdSize;
+            cmd.parmIndex = mParms.size();
+            mParms.resize(cmd.parmIndex + rdSize);
+            short *parm = mParms.data() + cmd.parmIndex;
+            qFromLittleEndian<qint16>(begin + pos, rdSize, parm);
+            pos += rdSize * sizeof(WORD);
+            mCmds.append(cmd);
+
+            if (rdFunc == 0x020B && rdSize >= 2) {           // SETWINDOWORG: dimensions
+                mBBox.setLeft(parm[ 1 ]);
+                mBBox.setTop(parm[ 0 ]);
             }
-
-            if (i < rdSize) {
-                qCDebug(KTNEFAPPS_LOG) << "WMF : file truncated !";
-                return false;
+            if (rdFunc == 0x020C && rdSize >= 2) {           // SETWINDOWEXT: dimensions
+                mBBox.setWidth(parm[ 1 ]);
+                mBBox.setHeight(parm[ 0 ]);
             }
         }
         //----- Test records validities
@@ -344,7 +331,6 @@ bool QWinMetaFile::load(QBuffer &buffer)
 bool QWinMetaFile::paint(QPaintDevice *aTarget, bool absolute)
 {
     int idx, i;
-    WmfCmd *cmd;
 
     if (!mValid) {
         return false;
@@ -378,9 +364,11 @@ bool QWinMetaFile::paint(QPaintDevice *aTarget, bool absolute)
     }
     mInternalWorldMatrix.reset();
 
-    for (cmd = mFirstCmd; cmd; cmd = cmd->next) {
-        idx = cmd->funcIndex;
-        (this->*metaFuncTab[ idx ].method)(cmd->numParm, cmd->parm);
+    short *const parms = mParms.data();
+    for (const WmfCmd &cmd : qAsConst(mCmds)) {
+        idx = cmd.funcIndex;
+        short *const parm = parms + cmd.parmIndex;
+        (this->*metaFuncTab[ idx ].method)(cmd.numParm, parm);
 
         if (QWMF_DEBUG) {
             QString str, param;
@@ -393,8 +381,8 @@ bool QWinMetaFile::paint(QPaintDevice *aTarget, bool absolute)
             str += QLatin1String(metaFuncTab[ idx ].name);
             str += QLatin1String(" : ");
 
-            for (i = 0; i < cmd->numParm; ++i) {
-                param.setNum(cmd->parm[ i ]);
+            for (i = 0; i < cmd.numParm; ++i) {
+                param.setNum(parm[ i ]);
                 str += param;
                 str += QLatin1Char(' ');
             }
@@ -839,10 +827,8 @@ void QWinMetaFile::dibStretchBlt(long num, short *parm)
             QTransform m(1.0F, 0.0F, 0.0F, -1.0F, 0.0F, 0.0F);
             mPainter.setWorldTransform(m, true);
         }
-        bmpSrc = bmpSrc.copy(parm[ 5 ], parm[ 4 ], parm[ 3 ], parm[ 2 ]);
-        // TODO: scale the bitmap ( QImage::scale(parm[ 7 ], parm[ 6 ]) is actually too slow )
-
-        mPainter.drawImage(parm[ 9 ], parm[ 8 ], bmpSrc);
+        drawDibImage(bmpSrc, QRect(parm[ 5 ], parm[ 4 ], parm[ 3 ], parm[ 2 ]),
+                     QRect(parm[ 9 ], parm[ 8 ], qAbs(parm[ 7 ]), qAbs(parm[ 6 ])));
         mPainter.restore();
     }
 }
@@ -867,10 +853,8 @@ void QWinMetaFile::stretchDib(long num, short *parm)
             QTransform m(1.0F, 0.0F, 0.0F, -1.0F, 0.0F, 0.0F);
             mPainter.setWorldTransform(m, true);
         }
-        bmpSrc = bmpSrc.copy(parm[ 6 ], parm[ 5 ], parm[ 4 ], parm[ 3 ]);
-        // TODO: scale the bitmap ( QImage::scale(parm[ 8 ], parm[ 7 ]) is actually too slow )
-
-        mPainter.drawImage(parm[ 10 ], parm[ 9 ], bmpSrc);
+        drawDibImage(bmpSrc, QRect(parm[ 6 ], parm[ 5 ], parm[ 4 ], parm[ 3 ]),
+                     QRect(parm[ 10 ], parm[ 9 ], qAbs(parm[ 8 ]), qAbs(parm[ 7 ])));
         mPainter.restore();
     }
 }
@@ -1044,18 +1028,40 @@ unsigned short QWinMetaFile::calcCheckSum(WmfPlaceableHeader *apmfh)
 }
 
 //-----------------------------------------------------------------------------
+namespace {
+// Index in metaFuncTab of each function by the low byte of its number,
+// which is unique in the table
+struct MetaFuncIndex {
+    MetaFuncIndex()
+    {
+        int count = 0;
+        while (metaFuncTab[ count ].name) {
+            ++count;
+        }
+        unknown = count;
+        for (int i = 0; i < 256; ++i) {
+            index[ i ] = unknown;
+        }
+        for (int i = count - 1; i >= 0; --i) {
+            index[ metaFuncTab[ i ].func & 0xff ] = i;
+        }
+    }
+
+    int index[ 256 ];
+    int unknown;
+};
+}
+
 int QWinMetaFile::findFunc(unsigned short aFunc) const
 {
-    int i;
-
-    for (i = 0; metaFuncTab[ i ].name; ++i) {
-        if (metaFuncTab[ i ].func == aFunc) {
-            return i;
-        }
+    static const MetaFuncIndex funcIndex;
+    const int i = funcIndex.index[ aFunc & 0xff ];
+    if (metaFuncTab[ i ].func == aFunc) {
+        return i;
     }
 
     // here : unknown function
-    return i;
+    return funcIndex.unknown;
 }
 
 //-----------------------------------------------------------------------------
@@ -1256,3 +1262,23 @@ bool QWinMetaFile::dibToBmp(QImage &bmp, const char *dib, long size)
         return true;
     }
 }
+
+//-----------------------------------------------------------------------------
+void QWinMetaFile::drawDibImage(const QImage &bmp, const QRect &source, const QRect &target)
+{
+    QImage image = bmp.copy(source);
+    if (target.isEmpty()) {
+        mPainter.drawImage(target.topLeft(), image);
+        return;
+    }
+    // Scale the bitmap to its size on the device, so that the painter only has to copy it
+    const QSize deviceSize = mPainter.combinedTransform().mapRect(QRectF(QPointF(0, 0), target.size())).size().toSize();
+    const QSize size = deviceSize.boundedTo(QSize(s_maximumScaledDibSize, s_maximumScaledDibSize));
+    if (size.isEmpty()) {
+        return;
+    }
+    if (image.size() != size) {
+        image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+    }
+    mPainter.drawImage(target, image);
+}
@@ -25,13 +25,23 @@
 #include <QColor>
 #include <QImage>
 #include <QRect>
+#include <QVector>
 
 class QBuffer;
 class QString;
-class WmfCmd;
 class WinObjHandle;
 struct WmfPlaceableHeader;
 
+/**
+ * A metafile record: the index of its function in the function table and the
+ * position of its parameters in the parameters of all the records.
+ */
+struct WmfCmd {
+    int funcIndex;
+    int numParm;
+    int parmIndex;
+};
+
 /**
  * QWinMetaFile is a WMF viewer based on Qt toolkit
  * How to use QWinMetaFile :
@@ -213,6 +223,9 @@ protected:
     /** Converts DIB to BMP */
     bool dibToBmp(QImage &bmp, const char *dib, long size);
 
+    /** Draws the part @p source of the DIB scaled to @p target */
+    void drawDibImage(const QImage &bmp, const QRect &source, const QRect &target);
+
 protected:
     QPainter mPainter;
     bool mIsPlaceable, mIsEnhanced, mValid;
@@ -228,7 +241,8 @@ protected:
     int mTextAlign, mRotation;
     bool mWinding;
 
-    WmfCmd *mFirstCmd;
+    QVector<WmfCmd> mCmds;
+    QVector<short> mParms;
     WinObjHandle **mObjHandleTab;
     QPolygon mPoints;
     int mDpi;
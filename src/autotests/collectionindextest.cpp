@@ -0,0 +1,159 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "collectionindextest.h"
+#include "../collectionindex.h"
+#include <AkonadiCore/EntityTreeModel>
+#include <QStandardItemModel>
+#include <QTest>
+
+static QStandardItem *createItem(Akonadi::Collection::Id id, const QString &name = QString())
+{
+    Akonadi::Collection collection(id);
+    collection.setName(name.isEmpty() ? QString::number(id) : name);
+    QStandardItem *item = new QStandardItem(collection.name());
+    item->setData(QVariant::fromValue(collection), Akonadi::EntityTreeModel::CollectionRole);
+    item->setData(id, Akonadi::EntityTreeModel::CollectionIdRole);
+    return item;
+}
+
+static QList<Akonadi::Collection::Id> ids(const Akonadi::Collection::List &collections)
+{
+    QList<Akonadi::Collection::Id> result;
+    for (const Akonadi::Collection &collection : collections) {
+        result << collection.id();
+    }
+    return result;
+}
+
+//1
+//  2
+//    3
+//  4
+//5
+static void fillModel(QStandardItemModel &model)
+{
+    QStandardItem *item1 = createItem(1);
+    QStandardItem *item2 = createItem(2);
+    item2->appendRow(createItem(3));
+    item1->appendRow(item2);
+    item1->appendRow(createItem(4));
+    model.appendRow(item1);
+    model.appendRow(createItem(5));
+}
+
+CollectionIndexTest::CollectionIndexTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+CollectionIndexTest::~CollectionIndexTest()
+{
+}
+
+void CollectionIndexTest::shouldBeEmptyForEmptyModel()
+{
+    QStandardItemModel model;
+    KMail::CollectionIndex index(&model);
+    QVERIFY(index.collections().isEmpty());
+    QVERIFY(index.subtree(1).isEmpty());
+    QCOMPARE(index.count(), 0);
+}
+
+void CollectionIndexTest::shouldListCollectionsDepthFirst()
+{
+    QStandardItemModel model;
+    fillModel(model);
+    KMail::CollectionIndex index(&model);
+    const QList<Akonadi::Collection::Id> expected = {1, 2, 3, 4, 5};
+    QCOMPARE(ids(index.collections()), expected);
+    QCOMPARE(index.count(), 5);
+}
+
+void CollectionIndexTest::shouldReturnSubtree()
+{
+    QStandardItemModel model;
+    fillModel(model);
+    KMail::CollectionIndex index(&model);
+    const QList<Akonadi::Collection::Id> expected = {2, 3};
+    QCOMPARE(ids(index.subtree(2)), expected);
+    QCOMPARE(ids(index.subtree(5)), QList<Akonadi::Collection::Id>() << 5);
+    QVERIFY(index.subtree(42).isEmpty());
+}
+
+void CollectionIndexTest::shouldFollowInsertedRows()
+{
+    QStandardItemModel model;
+    fillModel(model);
+    KMail::CollectionIndex index(&model);
+    QCOMPARE(index.count(), 5);
+
+    QStandardItem *item6 = createItem(6);
+    item6->appendRow(createItem(7));
+    model.item(0)->child(0)->insertRow(0, item6);
+    model.insertRow(1, createItem(8));
+
+    const QList<Akonadi::Collection::Id> expected = {1, 2, 6, 7, 3, 4, 8, 5};
+    QCOMPARE(ids(index.collections()), expected);
+    QCOMPARE(ids(index.subtree(6)), QList<Akonadi::Collection::Id>() << 6 << 7);
+}
+
+void CollectionIndexTest::shouldFollowRemovedRows()
+{
+    QStandardItemModel model;
+    fillModel(model);
+    KMail::CollectionIndex index(&model);
+    QCOMPARE(index.count(), 5);
+
+    model.item(0)->removeRow(0);
+    const QList<Akonadi::Collection::Id> expected = {1, 4, 5};
+    QCOMPARE(ids(index.collections()), expected);
+    QVERIFY(index.subtree(3).isEmpty());
+
+    model.removeRow(0);
+    QCOMPARE(ids(index.collections()), QList<Akonadi::Collection::Id>() << 5);
+    QCOMPARE(index.count(), 1);
+}
+
+void CollectionIndexTest::shouldFollowChangedData()
+{
+    QStandardItemModel model;
+    fillModel(model);
+    KMail::CollectionIndex index(&model);
+    QCOMPARE(index.count(), 5);
+
+    Akonadi::Collection collection(4);
+    collection.setName(QStringLiteral("renamed"));
+    model.item(0)->child(1)->setData(QVariant::fromValue(collection), Akonadi::EntityTreeModel::CollectionRole);
+    QCOMPARE(index.subtree(4).constFirst().name(), QStringLiteral("renamed"));
+}
+
+void CollectionIndexTest::shouldRebuildAfterMove()
+{
+    QStandardItemModel model;
+    fillModel(model);
+    KMail::CollectionIndex index(&model);
+    QCOMPARE(index.count(), 5);
+
+    model.sort(0, Qt::DescendingOrder);
+    const QList<Akonadi::Collection::Id> expected = {5, 1, 4, 2, 3};
+    QCOMPARE(ids(index.collections()), expected);
+}
+
+QTEST_GUILESS_MAIN(CollectionIndexTest)
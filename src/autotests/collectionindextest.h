@@ -0,0 +1,41 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef COLLECTIONINDEXTEST_H
+#define COLLECTIONINDEXTEST_H
+
+#include <QObject>
+
+class CollectionIndexTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CollectionIndexTest(QObject *parent = nullptr);
+    ~CollectionIndexTest();
+private Q_SLOTS:
+    void shouldBeEmptyForEmptyModel();
+    void shouldListCollectionsDepthFirst();
+    void shouldReturnSubtree();
+    void shouldFollowInsertedRows();
+    void shouldFollowRemovedRows();
+    void shouldFollowChangedData();
+    void shouldRebuildAfterMove();
+};
+
+#endif // COLLECTIONINDEXTEST_H
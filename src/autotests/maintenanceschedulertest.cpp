@@ -0,0 +1,148 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "maintenanceschedulertest.h"
+#include "../maintenancescheduler.h"
+#include <KSharedConfig>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QStandardPaths>
+#include <QTest>
+
+static KMail::MaintenanceScheduler::Task createTask(const QString &name, int *started, bool hasWork = true)
+{
+    KMail::MaintenanceScheduler::Task task;
+    task.name = name;
+    task.interval = 60 * 60;
+    task.start = [started, hasWork]() {
+        ++(*started);
+        return hasWork;
+    };
+    return task;
+}
+
+MaintenanceSchedulerTest::MaintenanceSchedulerTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+MaintenanceSchedulerTest::~MaintenanceSchedulerTest()
+{
+}
+
+void MaintenanceSchedulerTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void MaintenanceSchedulerTest::init()
+{
+    KSharedConfig::Ptr cfg = KSharedConfig::openConfig(QStringLiteral("kmailmaintenancerc"));
+    cfg->deleteGroup(QStringLiteral("LastRun"));
+    cfg->sync();
+}
+
+void MaintenanceSchedulerTest::shouldRunOneTaskAtATime()
+{
+    KMail::MaintenanceScheduler scheduler;
+    scheduler.setIdleTimeout(0);
+    scheduler.setCheckInterval(10);
+    int firstStarted = 0;
+    int secondStarted = 0;
+    scheduler.addTask(createTask(QStringLiteral("first"), &firstStarted));
+    scheduler.addTask(createTask(QStringLiteral("second"), &secondStarted));
+    scheduler.start(0);
+
+    QTRY_COMPARE(scheduler.runningTask(), QStringLiteral("first"));
+    QTest::qWait(100);
+    QCOMPARE(firstStarted, 1);
+    QCOMPARE(secondStarted, 0);
+
+    scheduler.taskFinished(QStringLiteral("second"));
+    QCOMPARE(scheduler.runningTask(), QStringLiteral("first"));
+
+    scheduler.taskFinished(QStringLiteral("first"));
+    QVERIFY(scheduler.lastRun(QStringLiteral("first")).isValid());
+    QTRY_COMPARE(scheduler.runningTask(), QStringLiteral("second"));
+    scheduler.taskFinished(QStringLiteral("second"));
+
+    //Not due before the interval
+    QTest::qWait(100);
+    QVERIFY(scheduler.runningTask().isEmpty());
+    QCOMPARE(firstStarted, 1);
+    QCOMPARE(secondStarted, 1);
+}
+
+void MaintenanceSchedulerTest::shouldPauseTaskOnUserActivity()
+{
+    KMail::MaintenanceScheduler scheduler;
+    scheduler.setIdleTimeout(200);
+    scheduler.setCheckInterval(10);
+    int started = 0;
+    int paused = 0;
+    int resumed = 0;
+    KMail::MaintenanceScheduler::Task task = createTask(QStringLiteral("task"), &started);
+    task.pause = [&paused]() {
+        ++paused;
+    };
+    task.resume = [&resumed]() {
+        ++resumed;
+    };
+    scheduler.addTask(task);
+    scheduler.start(0);
+    QTRY_COMPARE(started, 1);
+
+    QObject receiver;
+    QEvent event(QEvent::MouseButtonPress);
+    QCoreApplication::sendEvent(&receiver, &event);
+    QCOMPARE(paused, 1);
+    QCoreApplication::sendEvent(&receiver, &event);
+    QCOMPARE(paused, 1);
+    QCOMPARE(resumed, 0);
+
+    QTRY_COMPARE(resumed, 1);
+    QCOMPARE(scheduler.runningTask(), QStringLiteral("task"));
+    QCOMPARE(started, 1);
+}
+
+void MaintenanceSchedulerTest::shouldPersistLastRun()
+{
+    int started = 0;
+    {
+        KMail::MaintenanceScheduler scheduler;
+        scheduler.setIdleTimeout(0);
+        scheduler.setCheckInterval(10);
+        scheduler.addTask(createTask(QStringLiteral("task"), &started, false));
+        scheduler.start(0);
+        QTRY_VERIFY(scheduler.lastRun(QStringLiteral("task")).isValid());
+        QVERIFY(scheduler.runningTask().isEmpty());
+    }
+    QCOMPARE(started, 1);
+
+    KMail::MaintenanceScheduler scheduler;
+    scheduler.setIdleTimeout(0);
+    scheduler.setCheckInterval(10);
+    scheduler.addTask(createTask(QStringLiteral("task"), &started, false));
+    QVERIFY(scheduler.lastRun(QStringLiteral("task")).isValid());
+    scheduler.start(0);
+    QTest::qWait(100);
+    QCOMPARE(started, 1);
+}
+
+QTEST_GUILESS_MAIN(MaintenanceSchedulerTest)
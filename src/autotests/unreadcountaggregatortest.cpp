@@ -0,0 +1,77 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "unreadcountaggregatortest.h"
+#include "../unreadcountaggregator.h"
+#include <QTest>
+
+UnreadCountAggregatorTest::UnreadCountAggregatorTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+UnreadCountAggregatorTest::~UnreadCountAggregatorTest()
+{
+}
+
+void UnreadCountAggregatorTest::shouldHaveDefaultValue()
+{
+    KMail::UnreadCountAggregator aggregator;
+    QCOMPARE(aggregator.total(), qint64(0));
+    QVERIFY(aggregator.unreadCounts().isEmpty());
+    QCOMPARE(aggregator.unreadCount(42), qint64(0));
+}
+
+void UnreadCountAggregatorTest::shouldApplyDelta()
+{
+    KMail::UnreadCountAggregator aggregator;
+    QVERIFY(aggregator.setUnreadCount(1, 5));
+    QVERIFY(aggregator.setUnreadCount(2, 3));
+    QCOMPARE(aggregator.total(), qint64(8));
+    QVERIFY(!aggregator.setUnreadCount(1, 5));
+    QVERIFY(aggregator.setUnreadCount(1, 2));
+    QCOMPARE(aggregator.total(), qint64(5));
+    QCOMPARE(aggregator.unreadCount(1), qint64(2));
+    QVERIFY(aggregator.setUnreadCount(2, 0));
+    QCOMPARE(aggregator.total(), qint64(2));
+    QCOMPARE(aggregator.unreadCounts().count(), 1);
+}
+
+void UnreadCountAggregatorTest::shouldIgnoreNegativeCount()
+{
+    KMail::UnreadCountAggregator aggregator;
+    QVERIFY(!aggregator.setUnreadCount(1, -1));
+    QCOMPARE(aggregator.total(), qint64(0));
+    QVERIFY(aggregator.unreadCounts().isEmpty());
+}
+
+void UnreadCountAggregatorTest::shouldRemoveCollection()
+{
+    KMail::UnreadCountAggregator aggregator;
+    aggregator.setUnreadCount(1, 5);
+    aggregator.setUnreadCount(2, 3);
+    QVERIFY(aggregator.removeCollection(1));
+    QVERIFY(!aggregator.removeCollection(1));
+    QCOMPARE(aggregator.total(), qint64(3));
+    aggregator.clear();
+    QCOMPARE(aggregator.total(), qint64(0));
+    QVERIFY(aggregator.unreadCounts().isEmpty());
+}
+
+QTEST_GUILESS_MAIN(UnreadCountAggregatorTest)
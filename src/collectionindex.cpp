@@ -0,0 +1,216 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "collectionindex.h"
+#include "kmail_debug.h"
+
+#include <AkonadiCore/EntityTreeModel>
+#include <QAbstractItemModel>
+#include <QStack>
+
+using namespace KMail;
+
+//Key of the top-level collections in mChildren
+static const Akonadi::Collection::Id s_topLevelId = -1;
+
+CollectionIndex::CollectionIndex(QAbstractItemModel *model, QObject *parent)
+    : QObject(parent)
+    , mModel(model)
+{
+    connect(mModel, &QAbstractItemModel::rowsInserted, this, &CollectionIndex::slotRowsInserted);
+    connect(mModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &CollectionIndex::slotRowsAboutToBeRemoved);
+    connect(mModel, &QAbstractItemModel::dataChanged, this, &CollectionIndex::slotDataChanged);
+    connect(mModel, &QAbstractItemModel::rowsMoved, this, &CollectionIndex::invalidate);
+    connect(mModel, &QAbstractItemModel::layoutChanged, this, &CollectionIndex::invalidate);
+    connect(mModel, &QAbstractItemModel::modelReset, this, &CollectionIndex::invalidate);
+}
+
+CollectionIndex::~CollectionIndex()
+{
+}
+
+Akonadi::Collection::List CollectionIndex::collections()
+{
+    ensureUpToDate();
+    Akonadi::Collection::List result;
+    result.reserve(mCollections.count());
+    appendSubtree(s_topLevelId, result);
+    return result;
+}
+
+Akonadi::Collection::List CollectionIndex::subtree(Akonadi::Collection::Id id)
+{
+    ensureUpToDate();
+    Akonadi::Collection::List result;
+    const auto it = mCollections.constFind(id);
+    if (it != mCollections.constEnd()) {
+        result << it.value();
+        appendSubtree(id, result);
+    }
+    return result;
+}
+
+int CollectionIndex::count()
+{
+    ensureUpToDate();
+    return mCollections.count();
+}
+
+void CollectionIndex::appendSubtree(Akonadi::Collection::Id id, Akonadi::Collection::List &result) const
+{
+    //Same order as a recursive walk of the model
+    QStack<Akonadi::Collection::Id> stack;
+    const QVector<Akonadi::Collection::Id> topChildren = mChildren.value(id);
+    for (int i = topChildren.count() - 1; i >= 0; --i) {
+        stack.push(topChildren.at(i));
+    }
+    while (!stack.isEmpty()) {
+        const Akonadi::Collection::Id current = stack.pop();
+        result << mCollections.value(current);
+        const auto it = mChildren.constFind(current);
+        if (it != mChildren.constEnd()) {
+            for (int i = it->count() - 1; i >= 0; --i) {
+                stack.push(it->at(i));
+            }
+        }
+    }
+}
+
+Akonadi::Collection::Id CollectionIndex::collectionId(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return s_topLevelId;
+    }
+    return mModel->data(index, Akonadi::EntityTreeModel::CollectionIdRole).toLongLong();
+}
+
+void CollectionIndex::invalidate()
+{
+    mDirty = true;
+    mCollections.clear();
+    mChildren.clear();
+}
+
+void CollectionIndex::ensureUpToDate()
+{
+    if (!mDirty) {
+        return;
+    }
+    mDirty = false;
+    QVector<Akonadi::Collection::Id> topLevel;
+    for (int row = 0, total = mModel->rowCount(); row < total; ++row) {
+        if (!addRow(mModel->index(row, 0), topLevel, row)) {
+            qCWarning(KMAIL_LOG) << "Collection found twice in the model";
+        }
+    }
+    mChildren.insert(s_topLevelId, topLevel);
+}
+
+bool CollectionIndex::addRow(const QModelIndex &index, QVector<Akonadi::Collection::Id> &siblings, int position)
+{
+    const Akonadi::Collection collection = mModel->data(index, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
+    const Akonadi::Collection::Id id = collection.id();
+    if (mCollections.contains(id)) {
+        return false;
+    }
+    mCollections.insert(id, collection);
+    siblings.insert(position, id);
+    //Rows inserted with their children don't get a signal for the children
+    const int rowCount = mModel->rowCount(index);
+    bool ok = true;
+    if (rowCount > 0) {
+        QVector<Akonadi::Collection::Id> children;
+        children.reserve(rowCount);
+        for (int row = 0; row < rowCount; ++row) {
+            ok = addRow(mModel->index(row, 0, index), children, row) && ok;
+        }
+        mChildren.insert(id, children);
+    }
+    return ok;
+}
+
+void CollectionIndex::removeSubtree(Akonadi::Collection::Id id)
+{
+    mCollections.remove(id);
+    const QVector<Akonadi::Collection::Id> children = mChildren.take(id);
+    for (Akonadi::Collection::Id child : children) {
+        removeSubtree(child);
+    }
+}
+
+void CollectionIndex::slotRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (mDirty) {
+        return;
+    }
+    const Akonadi::Collection::Id parentId = collectionId(parent);
+    if (parentId != s_topLevelId && !mCollections.contains(parentId)) {
+        invalidate();
+        return;
+    }
+    QVector<Akonadi::Collection::Id> siblings = mChildren.take(parentId);
+    if (first > siblings.count()) {
+        invalidate();
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        if (!addRow(mModel->index(row, 0, parent), siblings, row)) {
+            invalidate();
+            return;
+        }
+    }
+    mChildren.insert(parentId, siblings);
+}
+
+void CollectionIndex::slotRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (mDirty) {
+        return;
+    }
+    const Akonadi::Collection::Id parentId = collectionId(parent);
+    QVector<Akonadi::Collection::Id> siblings = mChildren.take(parentId);
+    if (last >= siblings.count()) {
+        invalidate();
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        removeSubtree(siblings.at(row));
+    }
+    siblings.remove(first, last - first + 1);
+    if (!siblings.isEmpty()) {
+        mChildren.insert(parentId, siblings);
+    }
+}
+
+void CollectionIndex::slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (mDirty || topLeft.column() > 0) {
+        return;
+    }
+    const QModelIndex parent = topLeft.parent();
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        const Akonadi::Collection collection = mModel->data(mModel->index(row, 0, parent), Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
+        auto it = mCollections.find(collection.id());
+        if (it == mCollections.end()) {
+            invalidate();
+            return;
+        }
+        it.value() = collection;
+    }
+}
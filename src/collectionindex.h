@@ -0,0 +1,79 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef COLLECTIONINDEX_H
+#define COLLECTIONINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+#include <AkonadiCore/Collection>
+
+class QAbstractItemModel;
+class QModelIndex;
+
+namespace KMail {
+/**
+ * Flattened view of the collections of a collection model, kept up to date
+ * from the model signals. It returns all the collections, or a collection and
+ * its descendants, in the order of a depth-first walk of the model, without
+ * walking the model again for each query.
+ *
+ * Rows inserted, removed or changed are applied incrementally. A moved row,
+ * a layout change (e.g. sorting) or a reset rebuilds the index on the next
+ * query.
+ */
+class CollectionIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CollectionIndex(QAbstractItemModel *model, QObject *parent = nullptr);
+    ~CollectionIndex() override;
+
+    Q_REQUIRED_RESULT Akonadi::Collection::List collections();
+
+    /**
+     * Returns @p id and all its descendants, or an empty list if @p id is
+     * not in the model.
+     */
+    Q_REQUIRED_RESULT Akonadi::Collection::List subtree(Akonadi::Collection::Id id);
+
+    Q_REQUIRED_RESULT int count();
+
+private:
+    Q_DISABLE_COPY(CollectionIndex)
+    void slotRowsInserted(const QModelIndex &parent, int first, int last);
+    void slotRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void slotDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void invalidate();
+    void ensureUpToDate();
+    Q_REQUIRED_RESULT bool addRow(const QModelIndex &index, QVector<Akonadi::Collection::Id> &siblings, int position);
+    void removeSubtree(Akonadi::Collection::Id id);
+    void appendSubtree(Akonadi::Collection::Id id, Akonadi::Collection::List &result) const;
+    Q_REQUIRED_RESULT Akonadi::Collection::Id collectionId(const QModelIndex &index) const;
+
+    QAbstractItemModel *const mModel;
+    QHash<Akonadi::Collection::Id, Akonadi::Collection> mCollections;
+    //Children of each collection, in the order of the rows of the model
+    QHash<Akonadi::Collection::Id, QVector<Akonadi::Collection::Id> > mChildren;
+    bool mDirty = true;
+};
+}
+
+#endif // COLLECTIONINDEX_H
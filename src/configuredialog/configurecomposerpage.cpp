@@ -21,6 +21,7 @@ using namespace PimCommon::ConfigureImmutableWidgetUtils;
 #include "kmkernel.h"
 
 #include "kmmainwidget.h"
+#include "startuptracer.h"
 #include <PimCommon/AutoCorrectionWidget>
 #include <MessageComposer/ImageScalingWidget>
 #include <MessageComposer/MessageComposerSettings>
@@ -69,6 +70,7 @@ QString ComposerPage::helpAnchor() const
 ComposerPage::ComposerPage(QWidget *parent)
     : ConfigModuleWithTabs(parent)
 {
+    KMail::StartupTraceScope traceScope("ComposerPage");
     //
     // "General" tab:
     //
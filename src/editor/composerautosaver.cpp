@@ -0,0 +1,402 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "composerautosaver.h"
+#include "composer.h"
+#include "kmail_debug.h"
+
+#include <KLocalizedString>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QUuid>
+
+using namespace KMail;
+
+//Serializes the writes of all the composers, removing unreferenced attachments
+//must not run while another composer writes an attachment before its index
+static QMutex s_autoSaveMutex;
+
+static QString attachmentsDirectory()
+{
+    return ComposerAutoSaver::autoSaveDirectory() + QLatin1String("attachments/");
+}
+
+static QString indexFileName(const QString &fileName)
+{
+    return attachmentsDirectory() + fileName + QLatin1String(".json");
+}
+
+static bool writeFile(const QString &path, const QByteArray &data, QString &errorMessage)
+{
+    QSaveFile file(path);
+    file.setDirectWriteFallback(true);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        errorMessage = i18n("Could not write %1: %2", path, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+//Removes the attachments which are not referenced by any autosave file anymore
+static void removeUnreferencedAttachments()
+{
+    QDir dir(attachmentsDirectory());
+    QSet<QString> referenced;
+    const QStringList indexFiles = dir.entryList({QStringLiteral("*.json")}, QDir::Files);
+    for (const QString &indexFile : indexFiles) {
+        QFile file(dir.filePath(indexFile));
+        if (!file.open(QIODevice::ReadOnly)) {
+            //Don't risk losing attachments of a composer we can't read
+            return;
+        }
+        const QJsonArray attachments = QJsonDocument::fromJson(file.readAll()).array();
+        for (const QJsonValue &attachment : attachments) {
+            referenced.insert(attachment.toObject().value(QLatin1String("hash")).toString());
+        }
+    }
+    const QStringList blobs = dir.entryList(QDir::Files);
+    for (const QString &blob : blobs) {
+        if (!blob.endsWith(QLatin1String(".json")) && !referenced.contains(blob)) {
+            dir.remove(blob);
+        }
+    }
+}
+
+namespace {
+class RemoveUnreferencedAttachmentsJob : public QRunnable
+{
+public:
+    void run() override
+    {
+        QMutexLocker locker(&s_autoSaveMutex);
+        removeUnreferencedAttachments();
+    }
+};
+}
+
+static void removeAutoSaveFiles(const QString &fileName)
+{
+    QFile::remove(ComposerAutoSaver::autoSaveDirectory() + fileName);
+    if (QFile::remove(indexFileName(fileName))) {
+        QThreadPool::globalInstance()->start(new RemoveUnreferencedAttachmentsJob);
+    }
+}
+
+namespace KMail {
+struct AutoSaveAttachment {
+    QByteArray data;
+    QByteArray hash;
+    QString name;
+    QString fileName;
+    QString description;
+    QByteArray mimeType;
+    QByteArray charset;
+    int encoding = 0;
+    bool isInline = false;
+};
+
+//Shared by a job and its saver, which may be destroyed while the job runs
+struct AutoSaveJobControl {
+    QMutex mutex;
+    ComposerAutoSaver *saver = nullptr;
+    bool cleanupPending = false;
+    bool finished = false;
+};
+
+class AutoSaveJob : public QRunnable
+{
+public:
+    AutoSaveJob(const QSharedPointer<AutoSaveJobControl> &control, const QString &fileName, const KMime::Message::Ptr &message,
+                const QVector<AutoSaveAttachment> &attachments, const QByteArray &lastMessageDigest)
+        : mControl(control)
+        , mFileName(fileName)
+        , mMessage(message)
+        , mAttachments(attachments)
+        , mLastMessageDigest(lastMessageDigest)
+    {
+    }
+
+    void run() override
+    {
+        QMutexLocker locker(&s_autoSaveMutex);
+        QString errorMessage;
+        QVector<QByteArray> hashes;
+        hashes.reserve(mAttachments.count());
+        QDir().mkpath(attachmentsDirectory());
+
+        //Attachments first, the index must never reference a missing file
+        QJsonArray index;
+        bool attachmentRemoved = false;
+        for (AutoSaveAttachment &attachment : mAttachments) {
+            if (attachment.hash.isEmpty()) {
+                attachment.hash = QCryptographicHash::hash(attachment.data, QCryptographicHash::Sha1).toHex();
+            }
+            const QString path = attachmentsDirectory() + QString::fromLatin1(attachment.hash);
+            if (!attachment.data.isNull() && !QFile::exists(path)) {
+                writeFile(path, attachment.data, errorMessage);
+            }
+            hashes.append(attachment.hash);
+            QJsonObject entry;
+            entry.insert(QStringLiteral("hash"), QString::fromLatin1(attachment.hash));
+            entry.insert(QStringLiteral("name"), attachment.name);
+            entry.insert(QStringLiteral("fileName"), attachment.fileName);
+            entry.insert(QStringLiteral("description"), attachment.description);
+            entry.insert(QStringLiteral("mimeType"), QString::fromLatin1(attachment.mimeType));
+            entry.insert(QStringLiteral("charset"), QString::fromLatin1(attachment.charset));
+            entry.insert(QStringLiteral("encoding"), attachment.encoding);
+            entry.insert(QStringLiteral("inline"), attachment.isInline);
+            index.append(entry);
+        }
+        if (index.isEmpty()) {
+            attachmentRemoved = QFile::remove(indexFileName(mFileName));
+        } else {
+            QFile oldIndex(indexFileName(mFileName));
+            if (oldIndex.open(QIODevice::ReadOnly)) {
+                const QJsonArray oldAttachments = QJsonDocument::fromJson(oldIndex.readAll()).array();
+                for (const QJsonValue &attachment : oldAttachments) {
+                    if (!hashes.contains(attachment.toObject().value(QLatin1String("hash")).toString().toLatin1())) {
+                        attachmentRemoved = true;
+                        break;
+                    }
+                }
+                oldIndex.close();
+            }
+            writeFile(indexFileName(mFileName), QJsonDocument(index).toJson(QJsonDocument::Compact), errorMessage);
+        }
+
+        //Only the headers and the text change between two saves, don't rewrite them if they didn't
+        mMessage->assemble();
+        const QByteArray content = mMessage->encodedContent();
+        const QByteArray digest = QCryptographicHash::hash(content, QCryptographicHash::Sha1);
+        if (digest != mLastMessageDigest || !QFile::exists(ComposerAutoSaver::autoSaveDirectory() + mFileName)) {
+            writeFile(ComposerAutoSaver::autoSaveDirectory() + mFileName, content, errorMessage);
+        }
+
+        QMutexLocker controlLocker(&mControl->mutex);
+        mControl->finished = true;
+        ComposerAutoSaver *saver = mControl->saver;
+        //The saver is gone: the job removes the files it was asked to clean up
+        const bool cleanup = !saver && mControl->cleanupPending;
+        if (saver) {
+            //Posted while the saver can't be destroyed, its destructor discards it otherwise
+            const QByteArray messageDigest = errorMessage.isEmpty() ? digest : QByteArray();
+            QMetaObject::invokeMethod(saver, [saver, hashes, messageDigest, errorMessage]() {
+                saver->slotJobDone(hashes, messageDigest, errorMessage);
+            }, Qt::QueuedConnection);
+        }
+        controlLocker.unlock();
+
+        if (cleanup) {
+            QFile::remove(ComposerAutoSaver::autoSaveDirectory() + mFileName);
+            if (QFile::remove(indexFileName(mFileName))) {
+                attachmentRemoved = true;
+            }
+        }
+        if (attachmentRemoved) {
+            removeUnreferencedAttachments();
+        }
+    }
+
+private:
+    const QSharedPointer<AutoSaveJobControl> mControl;
+    const QString mFileName;
+    const KMime::Message::Ptr mMessage;
+    QVector<AutoSaveAttachment> mAttachments;
+    const QByteArray mLastMessageDigest;
+};
+}
+
+ComposerAutoSaver::ComposerAutoSaver(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ComposerAutoSaver::~ComposerAutoSaver()
+{
+    if (mRunningJob) {
+        QMutexLocker locker(&mRunningJob->mutex);
+        mRunningJob->saver = nullptr;
+        if (!mRunningJob->finished) {
+            //The job cleans up once it is done
+            mRunningJob->cleanupPending = mCleanupPending;
+            return;
+        }
+        //Its result is still queued, and discarded with us
+    }
+    if (mCleanupPending) {
+        removeAutoSaveFiles(mFileName);
+    }
+}
+
+QString ComposerAutoSaver::autoSaveDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String("/kmail2/autosave/");
+}
+
+void ComposerAutoSaver::setFileName(const QString &fileName)
+{
+    mFileName = fileName;
+    mLastMessageDigest.clear();
+}
+
+QString ComposerAutoSaver::fileName() const
+{
+    return mFileName;
+}
+
+bool ComposerAutoSaver::isSaving() const
+{
+    return !mRunningJob.isNull();
+}
+
+void ComposerAutoSaver::save(const KMime::Message::Ptr &message, const MessageCore::AttachmentPart::List &attachments)
+{
+    mPendingMessage = message;
+    mPendingAttachments = attachments;
+    mCleanupPending = false;
+    if (!mRunningJob) {
+        startJob();
+    }
+}
+
+void ComposerAutoSaver::cleanup()
+{
+    mPendingMessage.reset();
+    mPendingAttachments.clear();
+    mKnownAttachments.clear();
+    mLastMessageDigest.clear();
+    if (mFileName.isEmpty()) {
+        return;
+    }
+    if (mRunningJob) {
+        //The job would write the files again
+        mCleanupPending = true;
+        return;
+    }
+    removeAutoSaveFiles(mFileName);
+    mFileName.clear();
+}
+
+void ComposerAutoSaver::startJob()
+{
+    if (mFileName.isEmpty()) {
+        mFileName = QUuid::createUuid().toString();
+    }
+
+    //Only send the data of attachments which were not written yet
+    QVector<AutoSaveAttachment> attachments;
+    attachments.reserve(mPendingAttachments.count());
+    QHash<MessageCore::AttachmentPart *, KnownAttachment> knownAttachments;
+    for (const MessageCore::AttachmentPart::Ptr &part : qAsConst(mPendingAttachments)) {
+        AutoSaveAttachment attachment;
+        attachment.name = part->name();
+        attachment.fileName = part->fileName();
+        attachment.description = part->description();
+        attachment.mimeType = part->mimeType();
+        attachment.charset = part->charset();
+        attachment.encoding = part->encoding();
+        attachment.isInline = part->isInline();
+        const QByteArray data = part->data();
+        //We keep a reference to the data: the same buffer means unchanged content
+        const auto it = mKnownAttachments.constFind(part.data());
+        if (it != mKnownAttachments.cend() && it->data.constData() == data.constData() && it->data.size() == data.size()) {
+            attachment.hash = it->hash;
+            knownAttachments.insert(part.data(), *it);
+        } else {
+            attachment.data = data;
+        }
+        attachments.append(attachment);
+    }
+    //Forget about removed attachments
+    mKnownAttachments = knownAttachments;
+    mRunningAttachments = mPendingAttachments;
+
+    mRunningJob.reset(new AutoSaveJobControl);
+    mRunningJob->saver = this;
+    AutoSaveJob *job = new AutoSaveJob(mRunningJob, mFileName, mPendingMessage, attachments, mLastMessageDigest);
+    mPendingMessage.reset();
+    mPendingAttachments.clear();
+    QThreadPool::globalInstance()->start(job);
+}
+
+void ComposerAutoSaver::slotJobDone(const QVector<QByteArray> &hashes, const QByteArray &messageDigest, const QString &errorMessage)
+{
+    mRunningJob.reset();
+
+    if (mCleanupPending) {
+        mCleanupPending = false;
+        mRunningAttachments.clear();
+        removeAutoSaveFiles(mFileName);
+        mFileName.clear();
+        return;
+    }
+
+    //Attachments of a failed save are written again next time
+    for (int i = 0; errorMessage.isEmpty() && i < hashes.count() && i < mRunningAttachments.count(); ++i) {
+        const MessageCore::AttachmentPart::Ptr &part = mRunningAttachments.at(i);
+        if (!mKnownAttachments.contains(part.data())) {
+            mKnownAttachments.insert(part.data(), KnownAttachment{part->data(), hashes.at(i)});
+        }
+    }
+    mRunningAttachments.clear();
+    mLastMessageDigest = messageDigest;
+
+    if (!errorMessage.isEmpty()) {
+        qCWarning(KMAIL_LOG) << "Autosave failed:" << errorMessage;
+        Q_EMIT failed(i18n("Could not autosave message: %1", errorMessage));
+    }
+    if (mPendingMessage) {
+        startJob();
+    }
+}
+
+bool ComposerAutoSaver::restoreAttachments(const QString &fileName, KMail::Composer *composer)
+{
+    QFile indexFile(indexFileName(fileName));
+    if (!indexFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonArray attachments = QJsonDocument::fromJson(indexFile.readAll()).array();
+    for (const QJsonValue &value : attachments) {
+        const QJsonObject attachment = value.toObject();
+        QFile blob(attachmentsDirectory() + attachment.value(QLatin1String("hash")).toString());
+        if (!blob.open(QIODevice::ReadOnly)) {
+            qCWarning(KMAIL_LOG) << "Missing autosaved attachment" << blob.fileName();
+            continue;
+        }
+        composer->addAttachment(attachment.value(QLatin1String("name")).toString(),
+                                static_cast<KMime::Headers::contentEncoding>(attachment.value(QLatin1String("encoding")).toInt()),
+                                attachment.value(QLatin1String("charset")).toString(),
+                                blob.readAll(),
+                                attachment.value(QLatin1String("mimeType")).toString().toLatin1());
+    }
+    return true;
+}
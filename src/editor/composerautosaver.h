@@ -0,0 +1,100 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef COMPOSERAUTOSAVER_H
+#define COMPOSERAUTOSAVER_H
+
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <KMime/Message>
+#include <MessageCore/AttachmentPart>
+
+namespace KMail {
+class AutoSaveJob;
+struct AutoSaveJobControl;
+class Composer;
+
+/**
+ * Writes the autosave file of a composer from a thread of the global thread
+ * pool. The message is composed without its attachments on the UI thread,
+ * attachments are stored once in autosave/attachments/ named after a hash of
+ * their content, and only referenced by the later saves of the composer.
+ */
+class ComposerAutoSaver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ComposerAutoSaver(QObject *parent = nullptr);
+    ~ComposerAutoSaver() override;
+
+    /**
+     * Sets the name of the autosave file, e.g. when recovering it. A new one is
+     * created on the first save otherwise.
+     */
+    void setFileName(const QString &fileName);
+    Q_REQUIRED_RESULT QString fileName() const;
+
+    /**
+     * Saves @p message, which must not contain attachments, together with
+     * @p attachments. If a save is still running, only the last request is
+     * written after it.
+     */
+    void save(const KMime::Message::Ptr &message, const MessageCore::AttachmentPart::List &attachments);
+
+    Q_REQUIRED_RESULT bool isSaving() const;
+
+    /**
+     * Removes the autosave files, e.g. after the message was sent.
+     */
+    void cleanup();
+
+    Q_REQUIRED_RESULT static QString autoSaveDirectory();
+
+    /**
+     * Adds the attachments saved along the autosave file @p fileName to
+     * @p composer. Returns @c false if there were none.
+     */
+    static bool restoreAttachments(const QString &fileName, KMail::Composer *composer);
+
+Q_SIGNALS:
+    void failed(const QString &errorMessage);
+
+private:
+    Q_DISABLE_COPY(ComposerAutoSaver)
+    friend class AutoSaveJob;
+    struct KnownAttachment {
+        QByteArray data;
+        QByteArray hash;
+    };
+    void startJob();
+    void slotJobDone(const QVector<QByteArray> &hashes, const QByteArray &messageDigest, const QString &errorMessage);
+
+    QString mFileName;
+    QByteArray mLastMessageDigest;
+    KMime::Message::Ptr mPendingMessage;
+    MessageCore::AttachmentPart::List mPendingAttachments;
+    MessageCore::AttachmentPart::List mRunningAttachments;
+    QHash<MessageCore::AttachmentPart *, KnownAttachment> mKnownAttachments;
+    QSharedPointer<AutoSaveJobControl> mRunningJob;
+    bool mCleanupPending = false;
+};
+}
+
+#endif // COMPOSERAUTOSAVER_H
@@ -0,0 +1,109 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "composerpool.h"
+#include "kmcomposerwin.h"
+#include "kmkernel.h"
+#include "kmail_debug.h"
+
+#include <KIdentityManagement/IdentityManager>
+
+#include <QApplication>
+#include <QTimer>
+
+using namespace KMail;
+
+static const int s_poolSize = 1;
+//Don't compete with the startup of the main window
+static const int s_initialFillDelay = 30 * 1000;
+//Give the composer which was just taken time to show up
+static const int s_refillDelay = 3 * 1000;
+
+ComposerPool::ComposerPool(QObject *parent)
+    : QObject(parent)
+{
+    mRefillTimer = new QTimer(this);
+    mRefillTimer->setSingleShot(true);
+    connect(mRefillTimer, &QTimer::timeout, this, &ComposerPool::refill);
+
+    //Pooled composers were set up with the old settings
+    connect(kmkernel, &KMKernel::configChanged, this, &ComposerPool::clear);
+    connect(kmkernel->identityManager(), qOverload<>(&KIdentityManagement::IdentityManager::changed), this, &ComposerPool::clear);
+
+    scheduleRefill(s_initialFillDelay);
+}
+
+ComposerPool::~ComposerPool()
+{
+    for (const QPointer<KMComposerWin> &composer : qAsConst(mComposers)) {
+        delete composer.data();
+    }
+}
+
+KMComposerWin *ComposerPool::take()
+{
+    KMComposerWin *composer = nullptr;
+    while (!composer && !mComposers.isEmpty()) {
+        //Closed with all the other windows (e.g. closeAllKMailWindows())
+        composer = mComposers.takeLast().data();
+    }
+    scheduleRefill(s_refillDelay);
+    return composer;
+}
+
+void ComposerPool::clear()
+{
+    for (const QPointer<KMComposerWin> &composer : qAsConst(mComposers)) {
+        if (composer) {
+            composer->deleteLater();
+        }
+    }
+    mComposers.clear();
+    scheduleRefill(s_refillDelay);
+}
+
+void ComposerPool::scheduleRefill(int delay)
+{
+    if (!mRefillTimer->isActive()) {
+        mRefillTimer->start(delay);
+    }
+}
+
+void ComposerPool::refill()
+{
+    if (mComposers.count() >= s_poolSize) {
+        return;
+    }
+    //Only create composers while the user is not interacting with the application
+    if (QApplication::activePopupWidget() || QApplication::activeModalWidget()
+        || QApplication::mouseButtons() != Qt::NoButton || kmkernel->shuttingDown()) {
+        scheduleRefill(s_refillDelay);
+        return;
+    }
+
+    qCDebug(KMAIL_LOG) << "Preparing a composer for the pool";
+    KMComposerWin *composer = new KMComposerWin(KMime::Message::Ptr(), false, false);
+    composer->setPooled(true);
+    mComposers.append(composer);
+
+    //One at a time, the event loop gets a chance between two composers
+    if (mComposers.count() < s_poolSize) {
+        scheduleRefill(0);
+    }
+}
@@ -0,0 +1,68 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef COMPOSERPOOL_H
+#define COMPOSERPOOL_H
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+class KMComposerWin;
+class QTimer;
+
+namespace KMail {
+/**
+ * Keeps a few hidden composer windows ready, so that replying or composing a
+ * new message doesn't have to wait for the editor, the plugins and the
+ * identity, transport and dictionary widgets to be created.
+ *
+ * Composers are handed out once and never come back to the pool, the pool is
+ * refilled when the application is idle. The pool is emptied when the
+ * configuration or the identities change.
+ */
+class ComposerPool : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ComposerPool(QObject *parent = nullptr);
+    ~ComposerPool() override;
+
+    /**
+     * Returns a composer from the pool, or @c nullptr if the pool is empty.
+     * The caller takes ownership.
+     */
+    Q_REQUIRED_RESULT KMComposerWin *take();
+
+    /**
+     * Drops the pooled composers, they are recreated with the current settings.
+     */
+    void clear();
+
+private:
+    Q_DISABLE_COPY(ComposerPool)
+    void scheduleRefill(int delay);
+    void refill();
+
+    QVector<QPointer<KMComposerWin> > mComposers;
+    QTimer *mRefillTimer = nullptr;
+};
+}
+
+#endif // COMPOSERPOOL_H
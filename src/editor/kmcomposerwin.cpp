@@ -45,11 +45,14 @@
 #include "kmail_debug.h"
 #include "kmcommands.h"
 #include "kmcomposercreatenewcomposerjob.h"
+#include "composerautosaver.h"
+#include "composerpool.h"
 #include "kmcomposerglobalaction.h"
 #include "kmcomposerupdatetemplatejob.h"
 #include "kmkernel.h"
 #include "kmmainwidget.h"
 #include "kmmainwin.h"
+#include "recipientkeycache.h"
 #include "mailcomposeradaptor.h" // TODO port all D-Bus stuff...
 #include "settings/kmailsettings.h"
 #include "templatesconfiguration_kfg.h"
@@ -156,7 +159,6 @@
 
 #include <QGpgME/Protocol>
 #include <QGpgME/ExportJob>
-#include <QGpgME/KeyForMailboxJob>
 
 // KDE Frameworks includes
 #include <KActionCollection>
@@ -198,7 +200,6 @@
 #include <MessageComposer/PluginEditorConverterBeforeConvertingData>
 
 // GPGME
-#include <gpgme++/keylistresult.h>
 #include <gpgme++/key.h>
 
 #include <kio_version.h>
@@ -213,8 +214,6 @@ using Sonnet::DictionaryComboBox;
 using MailTransport::TransportManager;
 using MailTransport::Transport;
 
-Q_DECLARE_METATYPE(MessageComposer::Recipient::Ptr)
-
 KMail::Composer *KMail::makeComposer(const KMime::Message::Ptr &msg, bool lastSignState, bool lastEncryptState, Composer::TemplateContext context, uint identity, const QString &textSelection,
                                      const QString &customTemplate)
 {
@@ -223,9 +222,43 @@ KMail::Composer *KMail::makeComposer(const KMime::Message::Ptr &msg, bool lastSi
 
 KMail::Composer *KMComposerWin::create(const KMime::Message::Ptr &msg, bool lastSignState, bool lastEncryptState, Composer::TemplateContext context, uint identity, const QString &textSelection, const QString &customTemplate)
 {
+    if (KMComposerWin *composer = kmkernel->composerPool()->take()) {
+        composer->reuseFromPool(context, identity, textSelection, customTemplate);
+        if (msg) {
+            composer->setMessage(msg, lastSignState, lastEncryptState);
+        }
+        return composer;
+    }
     return new KMComposerWin(msg, lastSignState, lastEncryptState, context, identity, textSelection, customTemplate);
 }
 
+void KMComposerWin::setPooled(bool pooled)
+{
+    mPooled = pooled;
+    // A hidden composer waiting in the pool has nothing to save
+    updateAutoSave();
+}
+
+void KMComposerWin::reuseFromPool(TemplateContext context, uint identity, const QString &textSelection, const QString &customTemplate)
+{
+    mContext = context;
+    mId = identity;
+    mTextSelection = textSelection;
+    mCustomTemplate = customTemplate;
+    setPooled(false);
+
+    // Same state as if the composer had been created with this identity:
+    // the identity fields are filled in by setMessage()
+    disconnect(mIdentityConnection);
+    mComposerBase->identityCombo()->setCurrentIdentity(mId);
+    mIdentityConnection = connect(mComposerBase->identityCombo(), &KIdentityManagement::IdentityCombo::identityChanged, this, [this](uint val) {
+        slotIdentityChanged(val);
+    });
+    const KIdentityManagement::Identity &ident = kmkernel->identityManager()->identityForUoid(mId);
+    mComposerBase->dictionary()->setCurrentByDictionaryName(ident.dictionary());
+    setFcc(ident.fcc());
+}
+
 int KMComposerWin::s_composerNumber = 0;
 
 KMComposerWin::KMComposerWin(const KMime::Message::Ptr &aMsg, bool lastSignState, bool lastEncryptState, Composer::TemplateContext context, uint id, const QString &textSelection, const QString &customTemplate)
@@ -255,6 +288,16 @@ KMComposerWin::KMComposerWin(const KMime::Message::Ptr &aMsg, bool lastSignState
     connect(mComposerBase, &MessageComposer::ComposerViewBase::sentSuccessfully, this, &KMComposerWin::slotSendSuccessful);
     connect(mComposerBase, &MessageComposer::ComposerViewBase::modified, this, &KMComposerWin::setModified);
 
+    mAutoSaver = new KMail::ComposerAutoSaver(this);
+    connect(mAutoSaver, &KMail::ComposerAutoSaver::failed, this, [this](const QString &msg) {
+        slotSendFailed(msg, MessageComposer::ComposerViewBase::AutoSave);
+    });
+    mAutoSaveTimer = new QTimer(this);
+    mAutoSaveTimer->setSingleShot(true);
+    connect(mAutoSaveTimer, &QTimer::timeout, this, [this]() {
+        autoSaveMessage(false);
+    });
+
     (void)new MailcomposerAdaptor(this);
     mdbusObjectPath = QLatin1String("/Composer_") + QString::number(++s_composerNumber);
     QDBusConnection::sessionBus().registerObject(mdbusObjectPath, this);
@@ -320,6 +363,8 @@ KMComposerWin::KMComposerWin(const KMime::Message::Ptr &aMsg, bool lastSignState
     connect(recipientsEditor, &MessageComposer::RecipientsEditor::completionModeChanged, this, &KMComposerWin::slotCompletionModeChanged);
     connect(recipientsEditor, &MessageComposer::RecipientsEditor::sizeHintChanged, this, &KMComposerWin::recipientEditorSizeHintChanged);
     connect(recipientsEditor, &MessageComposer::RecipientsEditor::lineAdded, this, &KMComposerWin::slotRecipientEditorLineAdded);
+    connect(kmkernel->recipientKeyCache(), &KMail::RecipientKeyCache::keyResolved, this, &KMComposerWin::slotRecipientKeyResolved);
+    connect(kmkernel->recipientKeyCache(), &KMail::RecipientKeyCache::batchFinished, this, &KMComposerWin::slotRecipientKeyBatchFinished);
     mComposerBase->setRecipientsEditor(recipientsEditor);
 
     mEdtSubject = new PimCommon::LineEditWithAutoCorrection(mHeadersArea, QStringLiteral("kmail2rc"));
@@ -741,6 +786,11 @@ void KMComposerWin::writeConfig()
 
     // make sure config changes are written to disk, cf. bug 127538
     KMKernel::self()->slotSyncConfig();
+
+    //Pooled composers were set up with the settings written above
+    if (kmkernel->composerPool()) {
+        kmkernel->composerPool()->clear();
+    }
 }
 
 MessageComposer::Composer *KMComposerWin::createSimpleComposer()
@@ -1806,6 +1856,7 @@ void KMComposerWin::setMessage(const KMime::Message::Ptr &newMsg, bool lastSignS
 void KMComposerWin::setAutoSaveFileName(const QString &fileName)
 {
     mComposerBase->setAutoSaveFileName(fileName);
+    mAutoSaver->setFileName(fileName);
 }
 
 void KMComposerWin::setSigningAndEncryptionDisabled(bool v)
@@ -1868,6 +1919,10 @@ void KMComposerWin::changeModifiedState(bool modified)
 
 bool KMComposerWin::queryClose()
 {
+    // Never shown, don't save its settings over the ones of the real composers
+    if (mPooled) {
+        return true;
+    }
     if (!mComposerBase->editor()->checkExternalEditorFinished()) {
         return false;
     }
@@ -1906,7 +1961,7 @@ bool KMComposerWin::queryClose()
         }
         //else fall through: return true
     }
-    mComposerBase->cleanupAutoSave();
+    cleanupAutoSave();
 
     if (!mMiscComposers.isEmpty()) {
         qCWarning(KMAIL_LOG) << "Tried to close while composer was active";
@@ -1937,19 +1992,93 @@ void KMComposerWin::forceAutoSaveMessage()
 
 void KMComposerWin::autoSaveMessage(bool force)
 {
+    if (mPooled) {
+        return;
+    }
     if (isComposerModified() || force) {
         applyComposerSetting(mComposerBase);
         mComposerBase->saveMailSettings();
-        mComposerBase->autoSaveMessage();
+        startAutoSave();
         if (!force) {
             mWasModified = true;
             changeModifiedState(false);
         }
     } else {
-        mComposerBase->updateAutoSave();
+        updateAutoSave();
     }
 }
 
+void KMComposerWin::updateAutoSave()
+{
+    const int interval = KMailSettings::self()->autosaveInterval() * 1000 * 60;
+    if (mPooled || interval == 0) {
+        mAutoSaveTimer->stop();
+    } else {
+        mAutoSaveTimer->start(interval);
+    }
+}
+
+void KMComposerWin::startAutoSave()
+{
+    updateAutoSave();
+
+    // Encrypted messages are autosaved encrypted, which only messagelib knows how to do
+    if (mEncryptAction->isChecked()) {
+        mAutoSaver->cleanup();
+        mComposerBaseAutoSaved = true;
+        mComposerBase->autoSaveMessage();
+        return;
+    }
+
+    // The previous snapshot is still being composed, the next tick will catch up
+    if (mAutoSaveComposer) {
+        return;
+    }
+    if (mComposerBaseAutoSaved) {
+        mComposerBase->cleanupAutoSave();
+        mComposerBaseAutoSaved = false;
+    }
+
+    // Only the headers and the text are composed here, the attachments are
+    // written once from a thread by the autosaver
+    MessageComposer::Composer *composer = createSimpleComposer();
+    const MessageCore::AttachmentPart::List parts = composer->attachmentParts();
+    for (const MessageCore::AttachmentPart::Ptr &part : parts) {
+        composer->removeAttachmentPart(part);
+    }
+    mAutoSaveComposer = composer;
+    connect(composer, &MessageComposer::Composer::result, this, &KMComposerWin::slotAutoSaveComposeResult);
+    composer->start();
+}
+
+void KMComposerWin::slotAutoSaveComposeResult(KJob *job)
+{
+    MessageComposer::Composer *composer = static_cast<MessageComposer::Composer *>(job);
+    if (composer != mAutoSaveComposer) {
+        // Canceled by cleanupAutoSave()
+        return;
+    }
+    mAutoSaveComposer = nullptr;
+
+    if (composer->error() != MessageComposer::Composer::NoError) {
+        slotSendFailed(i18n("Could not autosave message: %1", job->errorString()), MessageComposer::ComposerViewBase::AutoSave);
+        return;
+    }
+    Q_ASSERT(composer->resultMessages().size() == 1);
+    mAutoSaver->save(composer->resultMessages().constFirst(), mComposerBase->attachmentModel()->attachments());
+}
+
+void KMComposerWin::cleanupAutoSave()
+{
+    if (mAutoSaveComposer) {
+        disconnect(mAutoSaveComposer.data(), &MessageComposer::Composer::result, this, &KMComposerWin::slotAutoSaveComposeResult);
+        mAutoSaveComposer = nullptr;
+    }
+    mComposerBase->cleanupAutoSave();
+    mComposerBaseAutoSaved = false;
+    mAutoSaver->cleanup();
+}
+
 bool KMComposerWin::encryptToSelf() const
 {
     return MessageComposer::MessageComposerSettings::self()->cryptoEncryptToSelf();
@@ -1970,7 +2099,7 @@ void KMComposerWin::slotSendSuccessful(Akonadi::Item::Id id)
         UndoSendManager::self()->addItem(id, subject(), KMailSettings::self()->undoSendDelay());
     }
     setModified(false);
-    mComposerBase->cleanupAutoSave();
+    cleanupAutoSave();
     mFolder = Akonadi::Collection(); // see dtor
     close();
 }
@@ -2565,7 +2694,8 @@ void KMComposerWin::forceDisableHtml()
 
 bool KMComposerWin::isComposing() const
 {
-    return mComposerBase && mComposerBase->isComposing();
+    return (mComposerBase && mComposerBase->isComposing())
+           || mAutoSaveComposer || (mAutoSaver && mAutoSaver->isSaving());
 }
 
 void KMComposerWin::disableForgottenAttachmentsCheck()
@@ -2732,17 +2862,18 @@ void KMComposerWin::doSend(MessageComposer::MessageSender::SendMethod method, Me
         if (!mPluginEditorCheckBeforeSendManagerInterface->execute(params)) {
             return;
         }
-        const QStringList recipients = {composerBaseToTrimmed, composerBaseCcTrimmed, composerBaseBccTrimmed};
-
         setEnabled(false);
 
-        // Validate the To:, CC: and BCC fields
-        AddressValidationJob *job = new AddressValidationJob(recipients.join(QLatin1String(", ")), this, this);
-        job->setDefaultDomain(defaultDomainName);
+        // Validate the To:, CC: and BCC fields. The validation usually already
+        // runs since the user asked to send, while the checks above were done.
+        AddressValidationJob *job = addressValidationJob();
         job->setProperty("method", static_cast<int>(method));
         job->setProperty("saveIn", static_cast<int>(saveIn));
-        connect(job, &Akonadi::ItemFetchJob::result, this, &KMComposerWin::slotDoDelayedSend);
-        job->start();
+        if (job->isFinished()) {
+            slotDoDelayedSend(job);
+        } else {
+            connect(job, &AddressValidationJob::result, this, &KMComposerWin::slotDoDelayedSend, Qt::UniqueConnection);
+        }
 
         // we'll call send from within slotDoDelaySend
     } else {
@@ -2757,8 +2888,43 @@ void KMComposerWin::doSend(MessageComposer::MessageSender::SendMethod method, Me
     }
 }
 
+AddressValidationJob *KMComposerWin::addressValidationJob()
+{
+    const QStringList recipients = {mComposerBase->to().trimmed(), mComposerBase->cc().trimmed(), mComposerBase->bcc().trimmed()};
+    const QString addresses = recipients.join(QLatin1String(", "));
+    const KIdentityManagement::Identity &ident = KMKernel::self()->identityManager()->identityForUoid(mComposerBase->identityCombo()->currentIdentity());
+    const QString defaultDomainName = ident.isNull() ? QString() : ident.defaultDomainName();
+
+    if (mAddressValidationJob) {
+        if (mAddressValidationJob->property("addresses").toString() == addresses
+            && mAddressValidationJob->property("defaultDomainName").toString() == defaultDomainName) {
+            return mAddressValidationJob;
+        }
+        // The recipients changed since it was started
+        mAddressValidationJob->kill();
+        mAddressValidationJob->deleteLater();
+    }
+
+    // Errors are shown when the result is used, not while other questions are asked
+    AddressValidationJob *job = new AddressValidationJob(addresses, this, this);
+    job->setAutoDelete(false);
+    job->setInteractive(false);
+    job->setDefaultDomain(defaultDomainName);
+    job->setProperty("addresses", addresses);
+    job->setProperty("defaultDomainName", defaultDomainName);
+    job->start();
+    mAddressValidationJob = job;
+    return job;
+}
+
 void KMComposerWin::slotDoDelayedSend(KJob *job)
 {
+    // Used once, a new send validates again
+    if (job == mAddressValidationJob) {
+        mAddressValidationJob = nullptr;
+    }
+    job->deleteLater();
+
     if (job->error()) {
         KMessageBox::error(this, job->errorText());
         setEnabled(true);
@@ -2769,6 +2935,9 @@ void KMComposerWin::slotDoDelayedSend(KJob *job)
 
     // Abort sending if one of the recipient addresses is invalid ...
     if (!validateJob->isValid()) {
+        if (!validateJob->errorMessage().isEmpty()) {
+            KMessageBox::sorry(this, validateJob->errorMessage(), i18n("Invalid Email Address"));
+        }
         setEnabled(true);
         return;
     }
@@ -2843,6 +3012,7 @@ void KMComposerWin::slotSendLater()
     }
     mComposerBase->setSendLaterInfo(nullptr);
     if (mComposerBase->editor()->checkExternalEditorFinished()) {
+        (void)addressValidationJob();
         const bool wasRegistered = sendLaterRegistered();
         if (wasRegistered) {
             SendLater::SendLaterInfo *info = nullptr;
@@ -2921,6 +3091,9 @@ void KMComposerWin::sendNow(bool shortcutUsed)
         return;
     }
     mSendNowByShortcutUsed = shortcutUsed;
+    // Resolve the addresses while spell checking, the phishing check and the
+    // questions before sending go on, doSend() picks the result up
+    (void)addressValidationJob();
     if (KMailSettings::self()->checkSpellingBeforeSend()) {
         mComposerBase->editor()->forceSpellChecking();
     } else {
@@ -3365,7 +3538,7 @@ void KMComposerWin::slotCompletionModeChanged(KCompletion::CompletionMode mode)
 void KMComposerWin::slotConfigChanged()
 {
     readConfig(true /*reload*/);
-    mComposerBase->updateAutoSave();
+    updateAutoSave();
     rethinkFields();
     slotWordWrapToggled(mWordWrapAction->isChecked());
 }
@@ -3586,9 +3759,9 @@ void KMComposerWin::slotRecipientEditorFocusChanged()
     for (auto line_ : lst) {
         auto line = qobject_cast<MessageComposer::RecipientLineNG *>(line_);
 
-        // There's still a lookup job running, so wait, slotKeyForMailBoxResult()
-        // will call us if the job returns empty key
-        if (line->property("keyLookupJob").isValid()) {
+        // There's still a key lookup running, so wait, slotRecipientKeyBatchFinished()
+        // will call us when it's done
+        if (line->property("keyLookupAddress").isValid()) {
             return;
         }
 
@@ -3647,32 +3820,11 @@ void KMComposerWin::slotRecipientAdded(MessageComposer::RecipientLineNG *line)
     }
 
     auto recipient = line->data().dynamicCast<MessageComposer::Recipient>();
-    // check if is an already running key lookup job and if so, cancel it
-    // this is to prevent a slower job overwriting results of the job that we
-    // are about to start now.
-    const auto runningJob = line->property("keyLookupJob").value<QPointer<QGpgME::KeyForMailboxJob> >();
-    if (runningJob) {
-        disconnect(runningJob.data(), &QGpgME::KeyForMailboxJob::result, this, &KMComposerWin::slotKeyForMailBoxResult);
-        runningJob->slotCancel();
-        line->setProperty("keyLookupJob", QVariant());
-    }
-
-    QGpgME::KeyForMailboxJob *job = protocol->keyForMailboxJob();
-    if (!job) {
-        line->setProperty("keyStatus", NoKey);
-        recipient->setEncryptionAction(Kleo::Impossible);
-        return;
-    }
-
-    QString dummy, addrSpec;
-    if (KEmailAddress::splitAddress(recipient->email(), dummy, addrSpec, dummy) != KEmailAddress::AddressOk) {
-        addrSpec = recipient->email();
-    }
-    line->setProperty("keyLookupJob", QVariant::fromValue(QPointer<QGpgME::KeyForMailboxJob>(job)));
-    job->setProperty("recipient", QVariant::fromValue(recipient));
-    job->setProperty("line", QVariant::fromValue(QPointer<MessageComposer::RecipientLineNG>(line)));
-    connect(job, &QGpgME::KeyForMailboxJob::result, this, &KMComposerWin::slotKeyForMailBoxResult);
-    job->start(addrSpec, true);
+    // Lookups are batched and cached by the key cache, remember which address
+    // this line waits for so that a late result for a previous address is ignored
+    const QString addrSpec = KMail::RecipientKeyCache::normalizedAddress(recipient->email());
+    line->setProperty("keyLookupAddress", addrSpec);
+    kmkernel->recipientKeyCache()->requestKey(addrSpec);
 }
 
 void KMComposerWin::slotRecipientFocusLost(MessageComposer::RecipientLineNG *line)
@@ -3690,7 +3842,7 @@ void KMComposerWin::slotRecipientFocusLost(MessageComposer::RecipientLineNG *lin
         return;
     }
 
-    if (line->property("keyLookupJob").toBool()) {
+    if (line->property("keyLookupAddress").isValid()) {
         return;
     }
 
@@ -3700,24 +3852,40 @@ void KMComposerWin::slotRecipientFocusLost(MessageComposer::RecipientLineNG *lin
     }
 }
 
-void KMComposerWin::slotKeyForMailBoxResult(const GpgME::KeyListResult &, const GpgME::Key &key, const GpgME::UserID &userID)
+void KMComposerWin::slotRecipientKeyResolved(const QString &address, const GpgME::Key &key, const GpgME::UserID &userID)
 {
-    QObject *job = sender();
-    Q_ASSERT(job);
+    const auto lst = mComposerBase->recipientsEditor()->lines();
+    for (auto line_ : lst) {
+        auto line = qobject_cast<MessageComposer::RecipientLineNG *>(line_);
+        if (!line || line->property("keyLookupAddress").toString() != address) {
+            continue;
+        }
+        line->setProperty("keyLookupAddress", QVariant());
+        mRecipientKeysChanged = true;
 
-    // Check if the encryption was explicitly disabled while the job was running
-    if (!mEncryptAction->isChecked() && mEncryptAction->property("setByUser").toBool()) {
-        return;
-    }
+        // Check if the encryption was explicitly disabled while the lookup was running
+        if (!mEncryptAction->isChecked() && mEncryptAction->property("setByUser").toBool()) {
+            continue;
+        }
 
-    auto recipient = job->property("recipient").value<MessageComposer::Recipient::Ptr>();
-    auto line = job->property("line").value<QPointer<MessageComposer::RecipientLineNG> >();
+        auto recipient = line->data().dynamicCast<MessageComposer::Recipient>();
+        if (recipient) {
+            applyRecipientKey(line, recipient, key, userID);
+        }
+    }
+}
 
-    if (!recipient || !line) {
-        return;
+void KMComposerWin::slotRecipientKeyBatchFinished()
+{
+    // Update the encryption state once for all the recipients of the batch
+    if (mRecipientKeysChanged) {
+        mRecipientKeysChanged = false;
+        slotRecipientEditorFocusChanged();
     }
+}
 
-    line->setProperty("keyLookupJob", QVariant());
+void KMComposerWin::applyRecipientKey(MessageComposer::RecipientLineNG *line, const MessageComposer::Recipient::Ptr &recipient, const GpgME::Key &key, const GpgME::UserID &userID)
+{
     if (key.isNull()) {
         recipient->setEncryptionAction(Kleo::Impossible); // no key
         line->setIcon(QIcon());
@@ -3756,8 +3924,6 @@ void KMComposerWin::slotKeyForMailBoxResult(const GpgME::KeyListResult &, const
 
         line->setProperty("keyStatus", KeyOk);
         line->setIcon(KIconUtils::addOverlay(icon, overlay, Qt::BottomRightCorner), tooltip);
-
-        slotRecipientEditorFocusChanged();
     }
 }
 
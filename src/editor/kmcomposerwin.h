@@ -32,6 +32,7 @@
 // Qt includes
 #include <QFont>
 #include <QList>
+#include <QPointer>
 #include <QVector>
 
 // LIBKDEPIM includes
@@ -75,6 +76,7 @@ class IncorrectIdentityFolderWarning;
 class KMailPluginEditorConvertTextManagerInterface;
 class KMailPluginGrammarEditorManagerInterface;
 class AttachmentAddedFromExternalWarning;
+class AddressValidationJob;
 namespace MailTransport {
 class Transport;
 }
@@ -108,8 +110,12 @@ class CustomToolsWidgetNg;
 class LineEditWithAutoCorrection;
 }
 
+namespace KMail {
+class ComposerAutoSaver;
+class ComposerPool;
+}
+
 namespace GpgME {
-class KeyListResult;
 class Key;
 class UserID;
 }
@@ -121,6 +127,7 @@ class KMComposerWin : public KMail::Composer
     Q_CLASSINFO("D-Bus Interface", "org.kde.kmail.mailcomposer")
 
     friend class ::KMComposerEditor;
+    friend class KMail::ComposerPool;
 
 private: // mailserviceimpl, kmkernel, kmcommands, callback, kmmainwidget
     explicit KMComposerWin(const KMime::Message::Ptr &msg, bool lastSignState, bool lastEncryptState, TemplateContext context = NoTemplate, uint identity = 0, const QString &textSelection = QString(), const QString &customTemplate = QString());
@@ -353,6 +360,7 @@ private Q_SLOTS:
     void recipientEditorSizeHintChanged();
     void setMaximumHeaderSize();
     void slotDoDelayedSend(KJob *);
+    AddressValidationJob *addressValidationJob();
 
     void slotCompletionModeChanged(KCompletion::CompletionMode);
     void slotConfigChanged();
@@ -372,6 +380,7 @@ private Q_SLOTS:
     void setAutoSaveFileName(const QString &fileName) override;
     void slotSpellCheckingLanguage(const QString &language);
     void forceAutoSaveMessage();
+    void slotAutoSaveComposeResult(KJob *job);
     void slotSaveAsFile();
 
     void slotAttachMissingFile();
@@ -399,7 +408,12 @@ private Q_SLOTS:
     void slotRecipientAdded(MessageComposer::RecipientLineNG *line);
     void slotRecipientLineIconClicked(MessageComposer::RecipientLineNG *line);
     void slotRecipientFocusLost(MessageComposer::RecipientLineNG *line);
-    void slotKeyForMailBoxResult(const GpgME::KeyListResult &result, const GpgME::Key &key, const GpgME::UserID &userID);
+    void setPooled(bool pooled);
+    void reuseFromPool(TemplateContext context, uint identity, const QString &textSelection, const QString &customTemplate);
+
+    void slotRecipientKeyResolved(const QString &address, const GpgME::Key &key, const GpgME::UserID &userID);
+    void slotRecipientKeyBatchFinished();
+    void applyRecipientKey(MessageComposer::RecipientLineNG *line, const MessageComposer::Recipient::Ptr &recipient, const GpgME::Key &key, const GpgME::UserID &userID);
 
     void slotDelayedCheckSendNow();
     void slotUpdateComposer(const KIdentityManagement::Identity &ident, const KMime::Message::Ptr &msg, uint uoid, uint uoldId, bool wasModified);
@@ -433,6 +447,9 @@ private:
     void updateSignature(uint uoid, uint uOldId);
     Q_REQUIRED_RESULT Kleo::CryptoMessageFormat cryptoMessageFormat() const;
     void printComposeResult(KJob *job, bool preview);
+    void updateAutoSave();
+    void startAutoSave();
+    void cleanupAutoSave();
     void printComposer(bool preview);
     /**
      * Install grid management and header fields. If fields exist that
@@ -654,6 +671,13 @@ private:
     bool mWasModified = false;
     CryptoStateIndicatorWidget *mCryptoStateIndicatorWidget = nullptr;
     bool mSendNowByShortcutUsed = false;
+    bool mRecipientKeysChanged = false;
+    bool mPooled = false;
+    KMail::ComposerAutoSaver *mAutoSaver = nullptr;
+    QTimer *mAutoSaveTimer = nullptr;
+    QPointer<MessageComposer::Composer> mAutoSaveComposer;
+    bool mComposerBaseAutoSaved = false;
+    QPointer<AddressValidationJob> mAddressValidationJob;
     KSplitterCollapserButton *mSnippetSplitterCollapser = nullptr;
     KToggleAction *mFollowUpToggleAction = nullptr;
     MessageComposer::StatusBarLabelToggledState *mStatusBarLabelToggledOverrideMode = nullptr;
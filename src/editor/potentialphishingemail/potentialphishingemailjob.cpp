@@ -34,7 +34,12 @@ PotentialPhishingEmailJob::~PotentialPhishingEmailJob()
 
 void PotentialPhishingEmailJob::setEmailWhiteList(const QStringList &emails)
 {
-    mEmailWhiteList = emails;
+    //Looked up for each recipient, the list can be long
+    mEmailWhiteList.clear();
+    mEmailWhiteList.reserve(emails.count());
+    for (const QString &email : emails) {
+        mEmailWhiteList.insert(email);
+    }
 }
 
 void PotentialPhishingEmailJob::setPotentialPhishingEmails(const QStringList &list)
@@ -22,6 +22,7 @@
 #define POTENTIALPHISHINGEMAILJOB_H
 
 #include <QObject>
+#include <QSet>
 #include <QStringList>
 
 class PotentialPhishingEmailJob : public QObject
@@ -46,7 +47,7 @@ private:
     Q_DISABLE_COPY(PotentialPhishingEmailJob)
     QStringList mEmails;
     QStringList mPotentialPhisingEmails;
-    QStringList mEmailWhiteList;
+    QSet<QString> mEmailWhiteList;
 };
 
 #endif // POTENTIALPHISHINGEMAILJOB_H
@@ -0,0 +1,246 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "recipientkeycache.h"
+#include "kmail_debug.h"
+
+#include <KEmailAddress>
+#include <Libkleo/KeyCache>
+#include <QGpgME/KeyListJob>
+#include <QGpgME/Protocol>
+#include <gpgme++/keylistresult.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QTimer>
+
+using namespace KMail;
+
+//Keys don't change often, but trust does (e.g. after signing a key on another
+//machine and syncing the keyring), so don't keep results forever.
+static const qint64 s_timeToLiveMSecs = 10 * 60 * 1000;
+//Recipients pasted or expanded from a group arrive one by one, wait a bit so
+//that they end up in the same key listing.
+static const int s_batchDelay = 100;
+
+static bool isUsableEncryptionKey(const GpgME::Key &key)
+{
+    return !key.isNull() && key.canEncrypt() && !key.isRevoked() && !key.isExpired()
+           && !key.isDisabled() && !key.isInvalid();
+}
+
+static QString gnupgHomeDirectory()
+{
+    const QString home = qEnvironmentVariable("GNUPGHOME");
+    return home.isEmpty() ? QDir::homePath() + QLatin1String("/.gnupg") : home;
+}
+
+RecipientKeyCache::RecipientKeyCache(QObject *parent)
+    : QObject(parent)
+{
+    mBatchTimer = new QTimer(this);
+    mBatchTimer->setSingleShot(true);
+    mBatchTimer->setInterval(s_batchDelay);
+    connect(mBatchTimer, &QTimer::timeout, this, &RecipientKeyCache::startBatch);
+
+    mKeyCache = Kleo::KeyCache::instance();
+    connect(mKeyCache.get(), &Kleo::KeyCache::keysMayHaveChanged,
+            this, &RecipientKeyCache::slotKeyringChanged);
+
+    //The Kleo key cache only notices changes made through it, keys imported
+    //or signed with gpg directly are only seen on the files.
+    mKeyringWatcher = new QFileSystemWatcher(this);
+    watchKeyringFiles();
+    connect(mKeyringWatcher, &QFileSystemWatcher::fileChanged, this, &RecipientKeyCache::slotKeyringChanged);
+}
+
+RecipientKeyCache::~RecipientKeyCache()
+{
+}
+
+QString RecipientKeyCache::normalizedAddress(const QString &address)
+{
+    QString dummy, addrSpec;
+    if (KEmailAddress::splitAddress(address, dummy, addrSpec, dummy) != KEmailAddress::AddressOk) {
+        addrSpec = address;
+    }
+    return addrSpec.trimmed().toLower();
+}
+
+bool RecipientKeyCache::cachedKey(const QString &address, GpgME::Key &key, GpgME::UserID &userID) const
+{
+    const auto it = mEntries.constFind(normalizedAddress(address));
+    if (it == mEntries.cend() || QDateTime::currentMSecsSinceEpoch() - it->timestamp > s_timeToLiveMSecs) {
+        return false;
+    }
+    key = it->key;
+    userID = it->userID;
+    return true;
+}
+
+void RecipientKeyCache::requestKey(const QString &address)
+{
+    const QString addr = normalizedAddress(address);
+    if (addr.isEmpty()) {
+        return;
+    }
+    mPendingAddresses.insert(addr);
+    if (!mJobRunning) {
+        mBatchTimer->start();
+    }
+}
+
+void RecipientKeyCache::clear()
+{
+    mEntries.clear();
+    if (mJobRunning) {
+        mDiscardRunningResults = true;
+    }
+}
+
+void RecipientKeyCache::slotKeyringChanged()
+{
+    qCDebug(KMAIL_LOG) << "Keyring changed, dropping cached recipient keys";
+    clear();
+    //Files replaced by gpg are dropped from the watcher
+    watchKeyringFiles();
+}
+
+void RecipientKeyCache::watchKeyringFiles()
+{
+    const QString homeDir = gnupgHomeDirectory();
+    const QStringList watchedFiles = mKeyringWatcher->files();
+    for (const QLatin1String &fileName : {QLatin1String("pubring.kbx"), QLatin1String("pubring.gpg"), QLatin1String("trustdb.gpg")}) {
+        const QString path = homeDir + QLatin1Char('/') + fileName;
+        if (QFile::exists(path) && !watchedFiles.contains(path)) {
+            mKeyringWatcher->addPath(path);
+        }
+    }
+}
+
+void RecipientKeyCache::startBatch()
+{
+    if (mJobRunning || mPendingAddresses.isEmpty()) {
+        return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList patterns;
+    bool resolvedFromCache = false;
+    for (const QString &addr : qAsConst(mPendingAddresses)) {
+        const auto it = mEntries.constFind(addr);
+        if (it != mEntries.cend() && now - it->timestamp <= s_timeToLiveMSecs) {
+            Q_EMIT keyResolved(addr, it->key, it->userID);
+            resolvedFromCache = true;
+        } else {
+            patterns.append(addr);
+        }
+    }
+    mPendingAddresses.clear();
+
+    if (patterns.isEmpty()) {
+        if (resolvedFromCache) {
+            Q_EMIT batchFinished();
+        }
+        return;
+    }
+
+    const auto protocol = QGpgME::openpgp();
+    QGpgME::KeyListJob *job = protocol ? protocol->keyListJob(false /*remote*/, false /*signatures*/, true /*validate*/) : nullptr;
+    if (!job) {
+        //No backend, remember that these addresses have no key
+        for (const QString &addr : qAsConst(patterns)) {
+            mEntries.insert(addr, Entry{GpgME::Key(), GpgME::UserID(), now});
+            Q_EMIT keyResolved(addr, GpgME::Key(), GpgME::UserID());
+        }
+        Q_EMIT batchFinished();
+        return;
+    }
+
+    mRunningAddresses.clear();
+    for (const QString &addr : qAsConst(patterns)) {
+        mRunningAddresses.insert(addr);
+    }
+    mFoundEntries.clear();
+    mDiscardRunningResults = false;
+    mJobRunning = true;
+    connect(job, &QGpgME::KeyListJob::nextKey, this, &RecipientKeyCache::slotNextKey);
+    connect(job, &QGpgME::KeyListJob::result, this, &RecipientKeyCache::slotKeyListResult);
+    const GpgME::Error err = job->start(patterns);
+    if (err) {
+        qCWarning(KMAIL_LOG) << "Unable to start key listing for recipients:" << err.asString();
+        slotKeyListResult(GpgME::KeyListResult(err));
+    }
+}
+
+void RecipientKeyCache::slotNextKey(const GpgME::Key &key)
+{
+    if (!isUsableEncryptionKey(key)) {
+        return;
+    }
+    //The patterns match substrings, keep only the user ids for the exact address
+    const auto userIDs = key.userIDs();
+    for (const GpgME::UserID &userID : userIDs) {
+        if (userID.isRevoked() || userID.isInvalid()) {
+            continue;
+        }
+        const QString addr = normalizedAddress(QString::fromUtf8(userID.email()));
+        if (!mRunningAddresses.contains(addr)) {
+            continue;
+        }
+        auto it = mFoundEntries.find(addr);
+        if (it == mFoundEntries.end()) {
+            mFoundEntries.insert(addr, Entry{key, userID, 0});
+        } else if (userID.validity() > it->userID.validity()) {
+            it->key = key;
+            it->userID = userID;
+        }
+    }
+}
+
+void RecipientKeyCache::slotKeyListResult(const GpgME::KeyListResult &result)
+{
+    if (!mJobRunning) {
+        return;
+    }
+    mJobRunning = false;
+
+    //Results of a listing which failed or raced with a keyring change are
+    //still given to the composers, but not cached
+    const bool cacheResults = !mDiscardRunningResults && !result.error();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const QString &addr : qAsConst(mRunningAddresses)) {
+        Entry entry = mFoundEntries.value(addr);
+        if (cacheResults) {
+            entry.timestamp = now;
+            mEntries.insert(addr, entry);
+        }
+        Q_EMIT keyResolved(addr, entry.key, entry.userID);
+    }
+    mRunningAddresses.clear();
+    mFoundEntries.clear();
+    mDiscardRunningResults = false;
+    Q_EMIT batchFinished();
+
+    if (!mPendingAddresses.isEmpty()) {
+        mBatchTimer->start();
+    }
+}
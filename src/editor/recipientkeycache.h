@@ -0,0 +1,98 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef RECIPIENTKEYCACHE_H
+#define RECIPIENTKEYCACHE_H
+
+#include <QHash>
+#include <QObject>
+#include <QSet>
+
+#include <gpgme++/key.h>
+
+#include <memory>
+
+class QFileSystemWatcher;
+class QTimer;
+namespace GpgME {
+class KeyListResult;
+}
+namespace Kleo {
+class KeyCache;
+}
+
+namespace KMail {
+/**
+ * Caches the OpenPGP encryption key found for recipient addresses, shared by
+ * all composer windows. Lookups requested in quick succession are resolved by
+ * a single key listing; the cache is dropped when the keyring changes.
+ */
+class RecipientKeyCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RecipientKeyCache(QObject *parent = nullptr);
+    ~RecipientKeyCache() override;
+
+    /**
+     * Returns @c true if @p address is in the cache. @p key is null if there
+     * is no usable encryption key for the address.
+     */
+    Q_REQUIRED_RESULT bool cachedKey(const QString &address, GpgME::Key &key, GpgME::UserID &userID) const;
+
+    /**
+     * Queues a lookup for @p address. keyResolved() is emitted for it when its
+     * batch is done, even if the address was already cached.
+     */
+    void requestKey(const QString &address);
+
+    void clear();
+
+    Q_REQUIRED_RESULT static QString normalizedAddress(const QString &address);
+
+Q_SIGNALS:
+    void keyResolved(const QString &address, const GpgME::Key &key, const GpgME::UserID &userID);
+    void batchFinished();
+
+private:
+    Q_DISABLE_COPY(RecipientKeyCache)
+    struct Entry {
+        GpgME::Key key;
+        GpgME::UserID userID;
+        qint64 timestamp = 0;
+    };
+    void startBatch();
+    void slotNextKey(const GpgME::Key &key);
+    void slotKeyListResult(const GpgME::KeyListResult &result);
+    void slotKeyringChanged();
+    void watchKeyringFiles();
+
+    QHash<QString, Entry> mEntries;
+    QHash<QString, Entry> mFoundEntries;
+    QSet<QString> mPendingAddresses;
+    QSet<QString> mRunningAddresses;
+    QTimer *mBatchTimer = nullptr;
+    QFileSystemWatcher *mKeyringWatcher = nullptr;
+    std::shared_ptr<const Kleo::KeyCache> mKeyCache;
+    bool mJobRunning = false;
+    bool mDiscardRunningResults = false;
+};
+}
+
+#endif // RECIPIENTKEYCACHE_H
@@ -0,0 +1,167 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "expirecollectionjob.h"
+#include "kmail_debug.h"
+
+#include <MailCommon/ExpireCollectionAttribute>
+#include <MailCommon/MailUtil>
+
+#include <AkonadiCore/ItemDeleteJob>
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <AkonadiCore/ItemMoveJob>
+#include <Akonadi/KMime/MessageStatus>
+#include <Akonadi/KMime/MessageParts>
+#include <KMime/Message>
+
+#include <KLocalizedString>
+#include <QDateTime>
+
+static const int s_expireBatchSize = 200;
+
+ExpireCollectionJob::ExpireCollectionJob(const Akonadi::Collection &collection, QObject *parent)
+    : QObject(parent)
+    , mCollection(collection)
+{
+}
+
+ExpireCollectionJob::~ExpireCollectionJob()
+{
+}
+
+void ExpireCollectionJob::setExcludeImportantMail(bool exclude)
+{
+    mExcludeImportantMail = exclude;
+}
+
+void ExpireCollectionJob::start()
+{
+    mElapsedTimer.start();
+    mInfo.collectionId = mCollection.id();
+    mInfo.collectionName = mCollection.name();
+
+    bool mustDeleteExpirationAttribute = false;
+    MailCommon::ExpireCollectionAttribute *attr = MailCommon::Util::expirationCollectionAttribute(mCollection, mustDeleteExpirationAttribute);
+    int unreadDays = 0;
+    int readDays = 0;
+    attr->daysToExpire(unreadDays, readDays);
+    const qint64 currentTime = QDateTime::currentSecsSinceEpoch();
+    if (unreadDays > 0) {
+        mMaxUnreadTime = currentTime - unreadDays * 3600 * 24;
+    }
+    if (readDays > 0) {
+        mMaxReadTime = currentTime - readDays * 3600 * 24;
+    }
+    if (attr->expireAction() == MailCommon::ExpireCollectionAttribute::ExpireMove) {
+        mMoveToCollection = Akonadi::Collection(attr->expireToFolderId());
+        mInfo.moved = true;
+    }
+    if (mustDeleteExpirationAttribute) {
+        delete attr;
+    }
+
+    if (mMaxUnreadTime == 0 && mMaxReadTime == 0) {
+        finish();
+        return;
+    }
+    if (mInfo.moved && (!mMoveToCollection.isValid() || mMoveToCollection == mCollection)) {
+        finish(i18n("Invalid folder to move expired messages to."));
+        return;
+    }
+
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mCollection, this);
+    job->setDeliveryOption(Akonadi::ItemFetchJob::EmitItemsInBatches);
+    job->fetchScope().fetchPayloadPart(Akonadi::MessagePart::Envelope);
+    job->fetchScope().setFetchModificationTime(false);
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &ExpireCollectionJob::slotItemsReceived);
+    connect(job, &Akonadi::ItemFetchJob::result, this, &ExpireCollectionJob::slotFetchResult);
+}
+
+void ExpireCollectionJob::slotItemsReceived(const Akonadi::Item::List &items)
+{
+    for (const Akonadi::Item &item : items) {
+        if (!item.hasPayload<KMime::Message::Ptr>()) {
+            continue;
+        }
+        Akonadi::MessageStatus status;
+        status.setStatusFromFlags(item.flags());
+        if (mExcludeImportantMail && (status.isImportant() || status.isToAct() || status.isWatched())) {
+            continue;
+        }
+        const qint64 maxTime = status.isRead() ? mMaxReadTime : mMaxUnreadTime;
+        if (maxTime == 0) {
+            continue;
+        }
+        const KMime::Message::Ptr msg = item.payload<KMime::Message::Ptr>();
+        const KMime::Headers::Date *date = msg->date(false);
+        if (date && date->dateTime().toSecsSinceEpoch() < maxTime) {
+            //Only keep id, we don't need the envelope anymore
+            mExpiredItems.append(Akonadi::Item(item.id()));
+        }
+    }
+}
+
+void ExpireCollectionJob::slotFetchResult(KJob *job)
+{
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to fetch items for expiry:" << job->errorString();
+        finish(job->errorString());
+        return;
+    }
+    applyNextBatch();
+}
+
+void ExpireCollectionJob::applyNextBatch()
+{
+    if (mExpiredItems.isEmpty()) {
+        finish();
+        return;
+    }
+    const Akonadi::Item::List batch = mExpiredItems.mid(0, s_expireBatchSize);
+    mExpiredItems.remove(0, batch.count());
+    mCurrentBatchCount = batch.count();
+    KJob *job = nullptr;
+    if (mInfo.moved) {
+        job = new Akonadi::ItemMoveJob(batch, mMoveToCollection, this);
+    } else {
+        job = new Akonadi::ItemDeleteJob(batch, this);
+    }
+    connect(job, &KJob::result, this, &ExpireCollectionJob::slotBatchResult);
+}
+
+void ExpireCollectionJob::slotBatchResult(KJob *job)
+{
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to expire messages:" << job->errorString();
+        finish(job->errorString());
+        return;
+    }
+    mInfo.expiredCount += mCurrentBatchCount;
+    applyNextBatch();
+}
+
+void ExpireCollectionJob::finish(const QString &errorString)
+{
+    mInfo.errorString = errorString;
+    mInfo.elapsedTime = mElapsedTimer.elapsed();
+    qCDebug(KMAIL_LOG) << "Expired" << mInfo.expiredCount << "messages from" << mInfo.collectionName << "in" << mInfo.elapsedTime << "ms";
+    Q_EMIT finished(mInfo);
+    deleteLater();
+}
@@ -0,0 +1,76 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef EXPIRECOLLECTIONJOB_H
+#define EXPIRECOLLECTIONJOB_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <AkonadiCore/Collection>
+#include <AkonadiCore/Item>
+class KJob;
+
+struct ExpireCollectionInfo {
+    Akonadi::Collection::Id collectionId = -1;
+    QString collectionName;
+    QString errorString;
+    qint64 elapsedTime = 0; //in ms
+    int expiredCount = 0;
+    bool moved = false;
+};
+Q_DECLARE_TYPEINFO(ExpireCollectionInfo, Q_MOVABLE_TYPE);
+
+/**
+ * Expires the old messages of one collection.
+ * Only envelopes are fetched, and expired messages are deleted or moved by batches.
+ */
+class ExpireCollectionJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ExpireCollectionJob(const Akonadi::Collection &collection, QObject *parent = nullptr);
+    ~ExpireCollectionJob();
+
+    void setExcludeImportantMail(bool exclude);
+
+    void start();
+
+Q_SIGNALS:
+    void finished(const ExpireCollectionInfo &info);
+
+private:
+    Q_DISABLE_COPY(ExpireCollectionJob)
+    void slotItemsReceived(const Akonadi::Item::List &items);
+    void slotFetchResult(KJob *job);
+    void slotBatchResult(KJob *job);
+    void applyNextBatch();
+    void finish(const QString &errorString = QString());
+
+    Akonadi::Collection mCollection;
+    Akonadi::Collection mMoveToCollection;
+    Akonadi::Item::List mExpiredItems;
+    ExpireCollectionInfo mInfo;
+    QElapsedTimer mElapsedTimer;
+    qint64 mMaxUnreadTime = 0;
+    qint64 mMaxReadTime = 0;
+    int mCurrentBatchCount = 0;
+    bool mExcludeImportantMail = false;
+};
+
+#endif // EXPIRECOLLECTIONJOB_H
@@ -0,0 +1,148 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "expiremanager.h"
+#include "kmail_debug.h"
+#include "kmkernel.h"
+
+#include <MailCommon/ExpireCollectionAttribute>
+#include <MailCommon/MailUtil>
+#include <Libkdepim/BroadcastStatus>
+
+#include <KLocalizedString>
+#include <QGuiApplication>
+
+static const int s_maximumRunningJobs = 4;
+
+ExpireManager::ExpireManager(QObject *parent)
+    : QObject(parent)
+{
+    connect(qApp, &QGuiApplication::applicationStateChanged, this, &ExpireManager::startNextJobs);
+}
+
+ExpireManager::~ExpireManager()
+{
+}
+
+bool ExpireManager::canBeExpired(const Akonadi::Collection &collection) const
+{
+    if (!collection.isValid() || MailCommon::Util::isVirtualCollection(collection)) {
+        return false;
+    }
+    bool mustDeleteExpirationAttribute = false;
+    MailCommon::ExpireCollectionAttribute *attr = MailCommon::Util::expirationCollectionAttribute(collection, mustDeleteExpirationAttribute);
+    const bool expire = attr->isAutoExpire()
+                        && (attr->unreadExpireUnits() != MailCommon::ExpireCollectionAttribute::ExpireNever
+                            || attr->readExpireUnits() != MailCommon::ExpireCollectionAttribute::ExpireNever);
+    if (mustDeleteExpirationAttribute) {
+        delete attr;
+    }
+    return expire;
+}
+
+void ExpireManager::start(const Akonadi::Collection::List &collections, bool immediate)
+{
+    for (const Akonadi::Collection &collection : collections) {
+        if (!canBeExpired(collection) || mImmediateCollections.contains(collection)) {
+            continue;
+        }
+        if (immediate) {
+            //Asked for by the user, it no longer waits with the scheduled ones
+            mPendingCollections.removeOne(collection);
+            mImmediateCollections.append(collection);
+        } else if (!mPendingCollections.contains(collection)) {
+            mPendingCollections.append(collection);
+        }
+    }
+    qCDebug(KMAIL_LOG) << "Number of collections to expire" << mImmediateCollections.count() + mPendingCollections.count();
+    startNextJobs();
+}
+
+void ExpireManager::pause()
+{
+    mPaused = true;
+}
+
+void ExpireManager::resume()
+{
+    mPaused = false;
+    startNextJobs();
+}
+
+bool ExpireManager::isRunning() const
+{
+    return mRunningJobs > 0 || !mImmediateCollections.isEmpty() || !mPendingCollections.isEmpty();
+}
+
+int ExpireManager::maximumRunningJobs() const
+{
+    if (qApp->applicationState() != Qt::ApplicationActive) {
+        return s_maximumRunningJobs;
+    }
+    return 1;
+}
+
+void ExpireManager::startJob(const Akonadi::Collection &collection)
+{
+    ExpireCollectionJob *job = new ExpireCollectionJob(collection, this);
+    job->setExcludeImportantMail(kmkernel->excludeImportantMailFromExpiry());
+    connect(job, &ExpireCollectionJob::finished, this, &ExpireManager::slotJobFinished);
+    ++mRunningJobs;
+    job->start();
+}
+
+void ExpireManager::startNextJobs()
+{
+    //An expiry asked for by the user isn't maintenance, it runs even while paused
+    while (mRunningJobs < s_maximumRunningJobs && !mImmediateCollections.isEmpty()) {
+        startJob(mImmediateCollections.takeFirst());
+    }
+    if (mPaused) {
+        return;
+    }
+    const int maximum = maximumRunningJobs();
+    while (mRunningJobs < maximum && !mPendingCollections.isEmpty()) {
+        startJob(mPendingCollections.takeFirst());
+    }
+}
+
+void ExpireManager::slotJobFinished(const ExpireCollectionInfo &info)
+{
+    --mRunningJobs;
+    if (info.expiredCount > 0 || !info.errorString.isEmpty()) {
+        mInfos.append(info);
+        Q_EMIT collectionExpired(info);
+    }
+    if (!info.errorString.isEmpty()) {
+        qCWarning(KMAIL_LOG) << "Expiry of" << info.collectionName << "failed:" << info.errorString;
+    }
+    startNextJobs();
+    if (mRunningJobs == 0 && mImmediateCollections.isEmpty() && mPendingCollections.isEmpty()) {
+        int expiredCount = 0;
+        for (const ExpireCollectionInfo &folderInfo : qAsConst(mInfos)) {
+            qCDebug(KMAIL_LOG) << "Expiry summary:" << folderInfo.collectionName << "expired:" << folderInfo.expiredCount << "time:" << folderInfo.elapsedTime << "ms";
+            expiredCount += folderInfo.expiredCount;
+        }
+        if (expiredCount > 0) {
+            KPIM::BroadcastStatus::instance()->setStatusMsg(i18np("Expired 1 old message.", "Expired %1 old messages.", expiredCount));
+        }
+        Q_EMIT finished(mInfos);
+        mInfos.clear();
+    }
+}
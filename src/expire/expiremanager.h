@@ -0,0 +1,68 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef EXPIREMANAGER_H
+#define EXPIREMANAGER_H
+
+#include <QObject>
+#include <QVector>
+#include <AkonadiCore/Collection>
+#include "expirecollectionjob.h"
+
+/**
+ * Runs the expiry of several collections, a bounded number of them in parallel.
+ * While KMail is the active application, scheduled expiry only runs one
+ * collection at a time so that it does not compete with the user.
+ * pause() only holds back scheduled expiry: the collections of an immediate
+ * start() run anyway, in their own queue.
+ */
+class ExpireManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ExpireManager(QObject *parent = nullptr);
+    ~ExpireManager();
+
+    void start(const Akonadi::Collection::List &collections, bool immediate);
+
+    void pause();
+    void resume();
+
+    Q_REQUIRED_RESULT bool isRunning() const;
+
+Q_SIGNALS:
+    void collectionExpired(const ExpireCollectionInfo &info);
+    void finished(const QVector<ExpireCollectionInfo> &infos);
+
+private:
+    Q_DISABLE_COPY(ExpireManager)
+    void startNextJobs();
+    void startJob(const Akonadi::Collection &collection);
+    void slotJobFinished(const ExpireCollectionInfo &info);
+    Q_REQUIRED_RESULT int maximumRunningJobs() const;
+    Q_REQUIRED_RESULT bool canBeExpired(const Akonadi::Collection &collection) const;
+
+    Akonadi::Collection::List mImmediateCollections;
+    Akonadi::Collection::List mPendingCollections;
+    QVector<ExpireCollectionInfo> mInfos;
+    int mRunningJobs = 0;
+    bool mPaused = false;
+};
+
+#endif // EXPIREMANAGER_H
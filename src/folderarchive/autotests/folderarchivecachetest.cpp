@@ -0,0 +1,105 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+#include "folderarchivecachetest.h"
+#include "../folderarchivecache.h"
+#include "../folderarchiveaccountinfo.h"
+#include "../folderarchiveutil.h"
+#include <KConfig>
+#include <QTest>
+#include <QStandardPaths>
+
+FolderArchiveCacheTest::FolderArchiveCacheTest(QObject *parent)
+    : QObject(parent)
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+FolderArchiveCacheTest::~FolderArchiveCacheTest()
+{
+}
+
+void FolderArchiveCacheTest::init()
+{
+    KConfig config(FolderArchive::FolderArchiveUtil::configFileName());
+    const QStringList groups = config.groupList();
+    for (const QString &group : groups) {
+        config.deleteGroup(group);
+    }
+    config.sync();
+}
+
+static FolderArchiveAccountInfo createInfo()
+{
+    FolderArchiveAccountInfo info;
+    info.setInstanceName(QStringLiteral("FOO"));
+    info.setArchiveTopLevel(Akonadi::Collection(42).id());
+    info.setFolderArchiveType(FolderArchiveAccountInfo::FolderByMonths);
+    info.setEnabled(true);
+    return info;
+}
+
+void FolderArchiveCacheTest::shouldBeEmptyByDefault()
+{
+    FolderArchiveCache cache;
+    FolderArchiveAccountInfo info = createInfo();
+    QCOMPARE(cache.collectionId(&info), Akonadi::Collection::Id(-1));
+}
+
+void FolderArchiveCacheTest::shouldRestoreCacheFromSettings()
+{
+    FolderArchiveAccountInfo info = createInfo();
+    {
+        FolderArchiveCache cache;
+        cache.addToCache(&info, 50);
+        QCOMPARE(cache.collectionId(&info), Akonadi::Collection::Id(50));
+    }
+    FolderArchiveCache restoredCache;
+    QCOMPARE(restoredCache.collectionId(&info), Akonadi::Collection::Id(50));
+}
+
+void FolderArchiveCacheTest::shouldInvalidateCacheWhenSettingsChanged()
+{
+    FolderArchiveAccountInfo info = createInfo();
+    FolderArchiveCache cache;
+    cache.addToCache(&info, 50);
+    info.setFolderArchiveType(FolderArchiveAccountInfo::FolderByYears);
+    QCOMPARE(cache.collectionId(&info), Akonadi::Collection::Id(-1));
+
+    cache.addToCache(&info, 51);
+    info.setArchiveTopLevel(43);
+    QCOMPARE(cache.collectionId(&info), Akonadi::Collection::Id(-1));
+
+    FolderArchiveCache restoredCache;
+    info.setArchiveTopLevel(42);
+    QCOMPARE(restoredCache.collectionId(&info), Akonadi::Collection::Id(-1));
+}
+
+void FolderArchiveCacheTest::shouldClearCacheWhenCollectionRemoved()
+{
+    FolderArchiveAccountInfo info = createInfo();
+    FolderArchiveCache cache;
+    cache.addToCache(&info, 50);
+    cache.clearCacheWithContainsCollection(50);
+    QCOMPARE(cache.collectionId(&info), Akonadi::Collection::Id(-1));
+
+    FolderArchiveCache restoredCache;
+    QCOMPARE(restoredCache.collectionId(&info), Akonadi::Collection::Id(-1));
+}
+
+QTEST_MAIN(FolderArchiveCacheTest)
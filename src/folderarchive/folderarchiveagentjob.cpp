@@ -29,7 +29,7 @@
 
 #include <KLocalizedString>
 
-FolderArchiveAgentJob::FolderArchiveAgentJob(FolderArchiveManager *manager, FolderArchiveAccountInfo *info, const Akonadi::Item::List &lstItem, QObject *parent)
+FolderArchiveAgentJob::FolderArchiveAgentJob(FolderArchiveManager *manager, const FolderArchiveAccountInfo &info, const Akonadi::Item::List &lstItem, QObject *parent)
     : QObject(parent)
     , mListItem(lstItem)
     , mManager(manager)
@@ -41,10 +41,27 @@ FolderArchiveAgentJob::~FolderArchiveAgentJob()
 {
 }
 
+void FolderArchiveAgentJob::addItems(const Akonadi::Item::List &lstItem)
+{
+    Q_ASSERT(!mStarted);
+    mListItem += lstItem;
+}
+
+bool FolderArchiveAgentJob::isStarted() const
+{
+    return mStarted;
+}
+
+QString FolderArchiveAgentJob::instanceName() const
+{
+    return mInfo.instanceName();
+}
+
 void FolderArchiveAgentJob::start()
 {
-    if (!mInfo->isValid()) {
-        sendError(i18n("Archive folder not defined. Please verify settings for account %1", mInfo->instanceName()));
+    mStarted = true;
+    if (!mInfo.isValid()) {
+        sendError(i18n("Archive folder not defined. Please verify settings for account %1", mInfo.instanceName()));
         return;
     }
     if (mListItem.isEmpty()) {
@@ -52,23 +69,29 @@ void FolderArchiveAgentJob::start()
         return;
     }
 
-    if (mInfo->folderArchiveType() == FolderArchiveAccountInfo::UniqueFolder) {
-        Akonadi::CollectionFetchJob *fetchCollection = new Akonadi::CollectionFetchJob(Akonadi::Collection(mInfo->archiveTopLevel()), Akonadi::CollectionFetchJob::Base);
+    if (mInfo.folderArchiveType() == FolderArchiveAccountInfo::UniqueFolder) {
+        Akonadi::CollectionFetchJob *fetchCollection = new Akonadi::CollectionFetchJob(Akonadi::Collection(mInfo.archiveTopLevel()), Akonadi::CollectionFetchJob::Base);
         connect(fetchCollection, &Akonadi::CollectionFetchJob::result, this, &FolderArchiveAgentJob::slotFetchCollection);
     } else {
-        Akonadi::Collection::Id id = mManager->folderArchiveCache()->collectionId(mInfo);
+        Akonadi::Collection::Id id = mManager->folderArchiveCache()->collectionId(&mInfo);
         if (id != -1) {
+            mUseCachedCollection = true;
             Akonadi::CollectionFetchJob *fetchCollection = new Akonadi::CollectionFetchJob(Akonadi::Collection(id), Akonadi::CollectionFetchJob::Base);
             connect(fetchCollection, &Akonadi::CollectionFetchJob::result, this, &FolderArchiveAgentJob::slotFetchCollection);
         } else {
-            FolderArchiveAgentCheckCollection *checkCol = new FolderArchiveAgentCheckCollection(mInfo, this);
-            connect(checkCol, &FolderArchiveAgentCheckCollection::collectionIdFound, this, &FolderArchiveAgentJob::slotCollectionIdFound);
-            connect(checkCol, &FolderArchiveAgentCheckCollection::checkFailed, this, &FolderArchiveAgentJob::slotCheckFailed);
-            checkCol->start();
+            checkCollection();
         }
     }
 }
 
+void FolderArchiveAgentJob::checkCollection()
+{
+    FolderArchiveAgentCheckCollection *checkCol = new FolderArchiveAgentCheckCollection(&mInfo, this);
+    connect(checkCol, &FolderArchiveAgentCheckCollection::collectionIdFound, this, &FolderArchiveAgentJob::slotCollectionIdFound);
+    connect(checkCol, &FolderArchiveAgentCheckCollection::checkFailed, this, &FolderArchiveAgentJob::slotCheckFailed);
+    checkCol->start();
+}
+
 void FolderArchiveAgentJob::slotCheckFailed(const QString &message)
 {
     sendError(i18n("Cannot fetch collection. %1", message));
@@ -76,12 +99,19 @@ void FolderArchiveAgentJob::slotCheckFailed(const QString &message)
 
 void FolderArchiveAgentJob::slotFetchCollection(KJob *job)
 {
+    Akonadi::CollectionFetchJob *fetchCollectionJob = static_cast<Akonadi::CollectionFetchJob *>(job);
+    if (mUseCachedCollection && (job->error() || fetchCollectionJob->collections().isEmpty())) {
+        //Cached collection was removed while we were not running, look it up again
+        mUseCachedCollection = false;
+        mManager->folderArchiveCache()->removeFromCache(mInfo.instanceName());
+        checkCollection();
+        return;
+    }
     if (job->error()) {
         sendError(i18n("Cannot fetch collection. %1", job->errorString()));
         return;
     }
-    Akonadi::CollectionFetchJob *fetchCollectionJob = static_cast<Akonadi::CollectionFetchJob *>(job);
-    Akonadi::Collection::List collections = fetchCollectionJob->collections();
+    const Akonadi::Collection::List collections = fetchCollectionJob->collections();
     if (collections.isEmpty()) {
         sendError(i18n("List of collections is empty. %1", job->errorString()));
         return;
@@ -91,7 +121,7 @@ void FolderArchiveAgentJob::slotFetchCollection(KJob *job)
 
 void FolderArchiveAgentJob::slotCollectionIdFound(const Akonadi::Collection &col)
 {
-    mManager->folderArchiveCache()->addToCache(mInfo->instanceName(), col.id());
+    mManager->folderArchiveCache()->addToCache(&mInfo, col.id());
     sloMoveMailsToCollection(col);
 }
 
@@ -102,13 +132,14 @@ void FolderArchiveAgentJob::sloMoveMailsToCollection(const Akonadi::Collection &
         connect(command, &KMMoveCommand::moveDone, this, &FolderArchiveAgentJob::slotMoveMessages);
         command->start();
     } else {
-        sendError(i18n("This folder %1 is read only. Please verify the configuration of account %2", col.name(), mInfo->instanceName()));
+        sendError(i18n("This folder %1 is read only. Please verify the configuration of account %2", col.name(), mInfo.instanceName()));
     }
 }
 
 void FolderArchiveAgentJob::sendError(const QString &error)
 {
     mManager->moveFailed(error);
+    mManager->jobFinished(this);
 }
 
 void FolderArchiveAgentJob::slotMoveMessages(KMMoveCommand *command)
@@ -118,4 +149,5 @@ void FolderArchiveAgentJob::slotMoveMessages(KMMoveCommand *command)
         return;
     }
     mManager->moveDone();
+    mManager->jobFinished(this);
 }
@@ -21,19 +21,23 @@
 
 #include <QObject>
 #include <AkonadiCore/Item>
+#include "folderarchiveaccountinfo.h"
 class KJob;
-class FolderArchiveAccountInfo;
 class FolderArchiveManager;
 class KMMoveCommand;
 class FolderArchiveAgentJob : public QObject
 {
     Q_OBJECT
 public:
-    explicit FolderArchiveAgentJob(FolderArchiveManager *manager, FolderArchiveAccountInfo *info, const Akonadi::Item::List &lstItem, QObject *parent = nullptr);
+    explicit FolderArchiveAgentJob(FolderArchiveManager *manager, const FolderArchiveAccountInfo &info, const Akonadi::Item::List &lstItem, QObject *parent = nullptr);
     ~FolderArchiveAgentJob();
 
     void start();
 
+    void addItems(const Akonadi::Item::List &lstItem);
+    Q_REQUIRED_RESULT bool isStarted() const;
+    Q_REQUIRED_RESULT QString instanceName() const;
+
 private:
     Q_DISABLE_COPY(FolderArchiveAgentJob)
     void slotFetchCollection(KJob *job);
@@ -42,10 +46,14 @@ private:
     void slotCollectionIdFound(const Akonadi::Collection &col);
     void slotMoveMessages(KMMoveCommand *);
 
+    void checkCollection();
     void sendError(const QString &error);
     Akonadi::Item::List mListItem;
     FolderArchiveManager *mManager = nullptr;
-    FolderArchiveAccountInfo *mInfo = nullptr;
+    //A copy, the manager replaces its infos when the settings are reloaded
+    FolderArchiveAccountInfo mInfo;
+    bool mStarted = false;
+    bool mUseCachedCollection = false;
 };
 
 #endif // FOLDERARCHIVEAGENTJOB_H
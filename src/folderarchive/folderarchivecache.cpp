@@ -19,26 +19,84 @@
 #include "folderarchivecache.h"
 #include "kmail_debug.h"
 #include "folderarchiveaccountinfo.h"
+#include "folderarchiveutil.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QRegularExpression>
 
 FolderArchiveCache::FolderArchiveCache(QObject *parent)
     : QObject(parent)
 {
+    readConfig();
 }
 
 FolderArchiveCache::~FolderArchiveCache()
 {
 }
 
+void FolderArchiveCache::readConfig()
+{
+    mCache.clear();
+    KConfig config(FolderArchive::FolderArchiveUtil::configFileName());
+    const QString pattern = FolderArchive::FolderArchiveUtil::groupCachePattern();
+    const QStringList cacheList = config.groupList().filter(QRegularExpression(QLatin1Char('^') + pattern));
+    for (const QString &groupName : cacheList) {
+        const KConfigGroup group = config.group(groupName);
+        ArchiveCache cache;
+        cache.colId = group.readEntry("collectionId", -1);
+        cache.topLevelId = group.readEntry("topLevelCollectionId", -1);
+        cache.folderArchiveType = group.readEntry("folderArchiveType", -1);
+        cache.date = group.readEntry("date", QDate());
+        if (cache.colId > -1 && cache.date.isValid()) {
+            mCache.insert(groupName.mid(pattern.length()), cache);
+        }
+    }
+}
+
+void FolderArchiveCache::writeCache(const QString &instanceName, const ArchiveCache &cache)
+{
+    KConfig config(FolderArchive::FolderArchiveUtil::configFileName());
+    KConfigGroup group = config.group(FolderArchive::FolderArchiveUtil::groupCachePattern() + instanceName);
+    group.writeEntry("collectionId", cache.colId);
+    group.writeEntry("topLevelCollectionId", cache.topLevelId);
+    group.writeEntry("folderArchiveType", cache.folderArchiveType);
+    group.writeEntry("date", cache.date);
+    config.sync();
+}
+
+void FolderArchiveCache::deleteCache(const QString &instanceName)
+{
+    KConfig config(FolderArchive::FolderArchiveUtil::configFileName());
+    const QString groupName = FolderArchive::FolderArchiveUtil::groupCachePattern() + instanceName;
+    if (config.hasGroup(groupName)) {
+        config.deleteGroup(groupName);
+        config.sync();
+    }
+}
+
 void FolderArchiveCache::clearCache()
 {
+    for (auto it = mCache.cbegin(), end = mCache.cend(); it != end; ++it) {
+        deleteCache(it.key());
+    }
     mCache.clear();
 }
 
+void FolderArchiveCache::removeFromCache(const QString &instanceName)
+{
+    if (mCache.remove(instanceName) > 0) {
+        deleteCache(instanceName);
+    }
+}
+
 void FolderArchiveCache::clearCacheWithContainsCollection(Akonadi::Collection::Id id)
 {
     QHash<QString, ArchiveCache>::iterator i = mCache.begin();
     while (i != mCache.end()) {
-        if (i.value().colId == id) {
+        if (i.value().colId == id || i.value().topLevelId == id) {
+            deleteCache(i.key());
             i = mCache.erase(i);
         } else {
             ++i;
@@ -49,46 +107,49 @@ void FolderArchiveCache::clearCacheWithContainsCollection(Akonadi::Collection::I
 Akonadi::Collection::Id FolderArchiveCache::collectionId(FolderArchiveAccountInfo *info)
 {
     //qCDebug(KMAIL_LOG)<<" Look at Cache ";
-    if (mCache.contains(info->instanceName())) {
-        //qCDebug(KMAIL_LOG)<<"instance name : "<<info->instanceName();
-        switch (info->folderArchiveType()) {
-        case FolderArchiveAccountInfo::UniqueFolder:
-            qCDebug(KMAIL_LOG) << "FolderArchiveAccountInfo::UniqueFolder has cache " << mCache.value(info->instanceName()).colId;
-            return mCache.value(info->instanceName()).colId;
-        case FolderArchiveAccountInfo::FolderByMonths:
-            //qCDebug(KMAIL_LOG)<<"FolderArchiveAccountInfo::ByMonths has cache ?";
-            if (mCache.value(info->instanceName()).date.month() != QDate::currentDate().month()) {
-                //qCDebug(KMAIL_LOG)<<"need to remove current cache month is not good";
-                mCache.remove(info->instanceName());
-                return -1;
-            } else {
-                return mCache.value(info->instanceName()).colId;
-            }
-        case FolderArchiveAccountInfo::FolderByYears:
-            //qCDebug(KMAIL_LOG)<<"FolderArchiveAccountInfo::ByYears has cache ?";
-            if (mCache.value(info->instanceName()).date.year() != QDate::currentDate().year()) {
-                //qCDebug(KMAIL_LOG)<<"need to remove current cache year is not good";
-                mCache.remove(info->instanceName());
-                return -1;
-            } else {
-                return mCache.value(info->instanceName()).colId;
-            }
+    const QString instanceName = info->instanceName();
+    auto it = mCache.constFind(instanceName);
+    if (it == mCache.constEnd()) {
+        //qCDebug(KMAIL_LOG)<<" Don't have cache for this instancename "<<info->instanceName();
+        return -1;
+    }
+    const ArchiveCache cache = it.value();
+    if (cache.topLevelId != info->archiveTopLevel() || cache.folderArchiveType != static_cast<int>(info->folderArchiveType())) {
+        qCDebug(KMAIL_LOG) << "Archive settings changed for" << instanceName << ", cache is not valid anymore";
+        removeFromCache(instanceName);
+        return -1;
+    }
+    const QDate currentDate = QDate::currentDate();
+    switch (info->folderArchiveType()) {
+    case FolderArchiveAccountInfo::UniqueFolder:
+        qCDebug(KMAIL_LOG) << "FolderArchiveAccountInfo::UniqueFolder has cache " << cache.colId;
+        return cache.colId;
+    case FolderArchiveAccountInfo::FolderByMonths:
+        //qCDebug(KMAIL_LOG)<<"FolderArchiveAccountInfo::ByMonths has cache ?";
+        if (cache.date.month() != currentDate.month() || cache.date.year() != currentDate.year()) {
+            //qCDebug(KMAIL_LOG)<<"need to remove current cache month is not good";
+            removeFromCache(instanceName);
+            return -1;
         }
-        return mCache.value(info->instanceName()).colId;
+        return cache.colId;
+    case FolderArchiveAccountInfo::FolderByYears:
+        //qCDebug(KMAIL_LOG)<<"FolderArchiveAccountInfo::ByYears has cache ?";
+        if (cache.date.year() != currentDate.year()) {
+            //qCDebug(KMAIL_LOG)<<"need to remove current cache year is not good";
+            removeFromCache(instanceName);
+            return -1;
+        }
+        return cache.colId;
     }
-    //qCDebug(KMAIL_LOG)<<" Don't have cache for this instancename "<<info->instanceName();
-    return -1;
+    return cache.colId;
 }
 
-void FolderArchiveCache::addToCache(const QString &resourceName, Akonadi::Collection::Id id)
+void FolderArchiveCache::addToCache(FolderArchiveAccountInfo *info, Akonadi::Collection::Id id)
 {
-    if (mCache.contains(resourceName)) {
-        ArchiveCache cache = mCache.value(resourceName);
-        cache.colId = id;
-        mCache.insert(resourceName, cache);
-    } else {
-        ArchiveCache cache;
-        cache.colId = id;
-        mCache.insert(resourceName, cache);
-    }
+    ArchiveCache cache;
+    cache.colId = id;
+    cache.topLevelId = info->archiveTopLevel();
+    cache.folderArchiveType = static_cast<int>(info->folderArchiveType());
+    mCache.insert(info->instanceName(), cache);
+    writeCache(info->instanceName(), cache);
 }
@@ -29,6 +29,9 @@ class FolderArchiveAccountInfo;
 struct ArchiveCache {
     QDate date = QDate::currentDate();
     Akonadi::Collection::Id colId = -1;
+    //Settings used to resolve colId, cache is invalid when they change
+    Akonadi::Collection::Id topLevelId = -1;
+    int folderArchiveType = -1;
 };
 
 class FolderArchiveCache : public QObject
@@ -38,7 +41,7 @@ public:
     explicit FolderArchiveCache(QObject *parent = nullptr);
     ~FolderArchiveCache();
 
-    void addToCache(const QString &resourceName, Akonadi::Collection::Id id);
+    void addToCache(FolderArchiveAccountInfo *info, Akonadi::Collection::Id id);
 
     Q_REQUIRED_RESULT Akonadi::Collection::Id collectionId(FolderArchiveAccountInfo *info);
 
@@ -46,8 +49,13 @@ public:
 
     void clearCache();
 
+    void removeFromCache(const QString &instanceName);
+
 private:
     Q_DISABLE_COPY(FolderArchiveCache)
+    void readConfig();
+    void writeCache(const QString &instanceName, const ArchiveCache &cache);
+    void deleteCache(const QString &instanceName);
     QHash<QString, ArchiveCache> mCache;
 };
 
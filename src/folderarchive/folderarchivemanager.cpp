@@ -36,6 +36,8 @@
 
 #include <QRegularExpression>
 
+static const int s_maximumRunningJobs = 3;
+
 FolderArchiveManager::FolderArchiveManager(QObject *parent)
     : QObject(parent)
 {
@@ -47,22 +49,21 @@ FolderArchiveManager::~FolderArchiveManager()
 {
     qDeleteAll(mListAccountInfo);
     mListAccountInfo.clear();
-    qDeleteAll(mJobQueue);
-    delete mCurrentJob;
+    qDeleteAll(mPendingJobs);
+    qDeleteAll(mRunningJobs);
 }
 
 void FolderArchiveManager::slotCollectionRemoved(const Akonadi::Collection &collection)
 {
-    KConfig config(FolderArchive::FolderArchiveUtil::configFileName());
     mFolderArchiveCache->clearCacheWithContainsCollection(collection.id());
     for (FolderArchiveAccountInfo *info : qAsConst(mListAccountInfo)) {
         if (info->archiveTopLevel() == collection.id()) {
+            KConfig config(FolderArchive::FolderArchiveUtil::configFileName());
             info->setArchiveTopLevel(-1);
             KConfigGroup group = config.group(FolderArchive::FolderArchiveUtil::groupConfigPattern() + info->instanceName());
             info->writeConfig(group);
         }
     }
-    load();
 }
 
 FolderArchiveAccountInfo *FolderArchiveManager::infoFromInstanceName(const QString &instanceName) const
@@ -124,13 +125,15 @@ void FolderArchiveManager::setArchiveItems(const Akonadi::Item::List &items, con
 {
     FolderArchiveAccountInfo *info = infoFromInstanceName(instanceName);
     if (info) {
-        FolderArchiveAgentJob *job = new FolderArchiveAgentJob(this, info, items);
-        if (mCurrentJob) {
-            mJobQueue.enqueue(job);
+        FolderArchiveAgentJob *job = mPendingJobs.value(instanceName);
+        if (job) {
+            //Same account => same archive folder, so move them together
+            job->addItems(items);
         } else {
-            mCurrentJob = job;
-            job->start();
+            mPendingJobs.insert(instanceName, new FolderArchiveAgentJob(this, *info, items));
+            mPendingInstances.enqueue(instanceName);
         }
+        startNextJobs();
     }
 }
 
@@ -140,7 +143,17 @@ void FolderArchiveManager::slotInstanceRemoved(const Akonadi::AgentInstance &ins
     for (FolderArchiveAccountInfo *info : qAsConst(mListAccountInfo)) {
         if (info->instanceName() == instanceName) {
             mListAccountInfo.removeAll(info);
+            delete info;
+            delete mPendingJobs.take(instanceName);
+            mPendingInstances.removeAll(instanceName);
+            //The account is gone, stop moving its messages
+            FolderArchiveAgentJob *runningJob = mRunningJobs.take(instanceName);
+            if (runningJob) {
+                runningJob->deleteLater();
+            }
+            mFolderArchiveCache->removeFromCache(instanceName);
             removeInfo(instanceName);
+            startNextJobs();
             break;
         }
     }
@@ -158,8 +171,7 @@ void FolderArchiveManager::load()
 {
     qDeleteAll(mListAccountInfo);
     mListAccountInfo.clear();
-    //Be sure to clear cache.
-    mFolderArchiveCache->clearCache();
+    //Cache entries are validated against the account settings in FolderArchiveCache::collectionId()
 
     KConfig config(FolderArchive::FolderArchiveUtil::configFileName());
     const QStringList accountList = config.groupList().filter(QRegularExpression(FolderArchive::FolderArchiveUtil::groupConfigPattern()));
@@ -183,7 +195,6 @@ void FolderArchiveManager::moveDone()
                          nullptr,
                          KNotification::CloseOnTimeout,
                          QStringLiteral("kmail2"));
-    nextJob();
 }
 
 void FolderArchiveManager::moveFailed(const QString &msg)
@@ -195,17 +206,31 @@ void FolderArchiveManager::moveFailed(const QString &msg)
                          nullptr,
                          KNotification::CloseOnTimeout,
                          QStringLiteral("kmail2"));
-    nextJob();
 }
 
-void FolderArchiveManager::nextJob()
+void FolderArchiveManager::jobFinished(FolderArchiveAgentJob *job)
 {
-    mCurrentJob->deleteLater();
-    if (mJobQueue.isEmpty()) {
-        mCurrentJob = nullptr;
-    } else {
-        mCurrentJob = mJobQueue.dequeue();
-        mCurrentJob->start();
+    mRunningJobs.remove(job->instanceName());
+    job->deleteLater();
+    startNextJobs();
+}
+
+void FolderArchiveManager::startNextJobs()
+{
+    int pendingCount = mPendingInstances.count();
+    while (mRunningJobs.count() < s_maximumRunningJobs && pendingCount > 0 && !mPendingInstances.isEmpty()) {
+        --pendingCount;
+        const QString instanceName = mPendingInstances.dequeue();
+        if (mRunningJobs.contains(instanceName)) {
+            //Wait that current job for this account is finished
+            mPendingInstances.enqueue(instanceName);
+            continue;
+        }
+        FolderArchiveAgentJob *job = mPendingJobs.take(instanceName);
+        if (job) {
+            mRunningJobs.insert(instanceName, job);
+            job->start();
+        }
     }
 }
 
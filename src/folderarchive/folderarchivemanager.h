@@ -20,6 +20,7 @@
 #define FOLDERARCHIVEMANAGER_H
 
 #include <QObject>
+#include <QHash>
 #include <QQueue>
 #include <AkonadiCore/Item>
 namespace Akonadi {
@@ -44,6 +45,7 @@ public:
 
     void moveFailed(const QString &msg);
     void moveDone();
+    void jobFinished(FolderArchiveAgentJob *job);
 
     void collectionRemoved(const Akonadi::Collection &collection);
 
@@ -60,10 +62,12 @@ private:
     void slotFetchCollection(KJob *job);
 
     FolderArchiveAccountInfo *infoFromInstanceName(const QString &instanceName) const;
-    void nextJob();
+    void startNextJobs();
     void removeInfo(const QString &instanceName);
-    QQueue<FolderArchiveAgentJob *> mJobQueue;
-    FolderArchiveAgentJob *mCurrentJob = nullptr;
+    //One job per account is running at a time, pending requests are merged into one job per account
+    QHash<QString, FolderArchiveAgentJob *> mRunningJobs;
+    QHash<QString, FolderArchiveAgentJob *> mPendingJobs;
+    QQueue<QString> mPendingInstances;
     QList<FolderArchiveAccountInfo *> mListAccountInfo;
     FolderArchiveCache *mFolderArchiveCache = nullptr;
 };
@@ -28,6 +28,11 @@ QString FolderArchiveUtil::groupConfigPattern()
     return QStringLiteral("FolderArchiveAccount ");
 }
 
+QString FolderArchiveUtil::groupCachePattern()
+{
+    return QStringLiteral("FolderArchiveCache ");
+}
+
 QString FolderArchiveUtil::configFileName()
 {
     return QStringLiteral("foldermailarchiverc");
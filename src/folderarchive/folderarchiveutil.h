@@ -23,6 +23,7 @@
 namespace FolderArchive {
 namespace FolderArchiveUtil {
 Q_REQUIRED_RESULT QString groupConfigPattern();
+Q_REQUIRED_RESULT QString groupCachePattern();
 Q_REQUIRED_RESULT bool resourceSupportArchiving(const QString &resource);
 Q_REQUIRED_RESULT QString configFileName();
 }
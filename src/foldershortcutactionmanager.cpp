@@ -28,8 +28,10 @@
 
 #include <QAction>
 #include <KActionCollection>
+#include <KConfigGroup>
 #include <KLocalizedString>
 #include <QIcon>
+#include <QTimer>
 
 using namespace KMail;
 using namespace MailCommon;
@@ -65,59 +67,97 @@ FolderShortcutActionManager::FolderShortcutActionManager(QWidget *parent, KActio
     , mActionCollection(actionCollection)
     , mParent(parent)
 {
+    //The model is filled in many small steps at startup, look for the collections once per batch
+    mPendingTimer = new QTimer(this);
+    mPendingTimer->setSingleShot(true);
+    mPendingTimer->setInterval(0);
+    connect(mPendingTimer, &QTimer::timeout, this, &FolderShortcutActionManager::createPendingActions);
 }
 
 void FolderShortcutActionManager::createActions()
 {
-    // When this function is called, the ETM has not finished loading yet. Therefore, when new
-    // rows are inserted in the ETM, see if we have new collections that we can assign shortcuts
-    // to.
+    // When this function is called, the ETM has not finished loading yet. Therefore, the
+    // shortcuts of the collections which are not loaded yet are kept, and looked for again
+    // when new rows are inserted in the ETM.
     const QAbstractItemModel *model = KernelIf->collectionModel();
     connect(model, &QAbstractItemModel::rowsInserted,
             this, &FolderShortcutActionManager::slotRowsInserted, Qt::UniqueConnection);
     connect(KernelIf->folderCollectionMonitor(), &Akonadi::Monitor::collectionRemoved,
             this, &FolderShortcutActionManager::slotCollectionRemoved, Qt::UniqueConnection);
 
-    const int rowCount(model->rowCount());
-    if (rowCount > 0) {
-        updateShortcutsForIndex(QModelIndex(), 0, rowCount - 1);
-    }
+    loadShortcuts();
+    createPendingActions();
 }
 
-void FolderShortcutActionManager::slotRowsInserted(const QModelIndex &parent, int start, int end)
+void FolderShortcutActionManager::loadShortcuts()
 {
-    updateShortcutsForIndex(parent, start, end);
+    // Read the shortcuts from the folder settings groups directly, instead of creating
+    // the settings of each collection
+    // The groups are named after the collection id, e.g. "Folder-42"
+    const QString groupName = FolderSettings::configGroupName(Akonadi::Collection(0));
+    const QString groupPrefix = groupName.left(groupName.length() - 1);
+    const KSharedConfig::Ptr config = KernelIf->config();
+    mPendingShortcuts.clear();
+    const QStringList groupList = config->groupList();
+    for (const QString &group : groupList) {
+        if (!group.startsWith(groupPrefix)) {
+            continue;
+        }
+        bool ok = false;
+        const Akonadi::Collection::Id id = group.midRef(groupPrefix.length()).toLongLong(&ok);
+        if (!ok) {
+            continue;
+        }
+        const QKeySequence shortcut(config->group(group).readEntry("Shortcut", QString()));
+        if (!shortcut.isEmpty()) {
+            mPendingShortcuts.insert(id, shortcut);
+        }
+    }
 }
 
-void FolderShortcutActionManager::updateShortcutsForIndex(const QModelIndex &parent, int start, int end)
+void FolderShortcutActionManager::createPendingActions()
 {
-    QAbstractItemModel *model = KernelIf->collectionModel();
-    for (int i = start; i <= end; ++i) {
-        if (model->hasIndex(i, 0, parent)) {
-            const QModelIndex child = model->index(i, 0, parent);
-            Akonadi::Collection collection
-                = model->data(child, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
-            if (collection.isValid()) {
-                shortcutChanged(collection);
-            }
-            if (model->hasChildren(child)) {
-                updateShortcutsForIndex(child, 0, model->rowCount(child) - 1);
-            }
+    const QAbstractItemModel *model = KernelIf->collectionModel();
+    for (auto it = mPendingShortcuts.begin(); it != mPendingShortcuts.end();) {
+        const QModelIndex index = Akonadi::EntityTreeModel::modelIndexForCollection(model, Akonadi::Collection(it.key()));
+        const Akonadi::Collection collection = index.isValid()
+                                               ? model->data(index, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>()
+                                               : Akonadi::Collection();
+        if (collection.isValid()) {
+            createShortcutAction(collection, it.value());
+            it = mPendingShortcuts.erase(it);
+        } else {
+            ++it;
         }
     }
 }
 
+void FolderShortcutActionManager::slotRowsInserted(const QModelIndex &parent, int start, int end)
+{
+    Q_UNUSED(parent);
+    Q_UNUSED(start);
+    Q_UNUSED(end);
+    if (!mPendingShortcuts.isEmpty()) {
+        mPendingTimer->start();
+    }
+}
+
 void FolderShortcutActionManager::slotCollectionRemoved(const Akonadi::Collection &col)
 {
     delete mFolderShortcutCommands.take(col.id());
 }
 
 void FolderShortcutActionManager::shortcutChanged(const Akonadi::Collection &col)
+{
+    mPendingShortcuts.remove(col.id());
+    const QSharedPointer<FolderSettings> folderCollection(FolderSettings::forCollection(col, false));
+    createShortcutAction(col, folderCollection->shortcut());
+}
+
+void FolderShortcutActionManager::createShortcutAction(const Akonadi::Collection &col, const QKeySequence &shortcut)
 {
     // remove the old one, no autodelete in Qt4
     slotCollectionRemoved(col);
-    const QSharedPointer<FolderSettings> folderCollection(FolderSettings::forCollection(col, false));
-    const QKeySequence shortcut(folderCollection->shortcut());
     if (shortcut.isEmpty()) {
         return;
     }
@@ -24,10 +24,12 @@
 #include <AkonadiCore/Collection>
 
 #include <QHash>
+#include <QKeySequence>
 #include <QModelIndex>
 #include <QObject>
 
 class QAction;
+class QTimer;
 
 class KActionCollection;
 
@@ -83,8 +85,13 @@ private:
 
 private:
     Q_DISABLE_COPY(FolderShortcutActionManager)
-    void updateShortcutsForIndex(const QModelIndex &parent, int start, int end);
+    void loadShortcuts();
+    void createPendingActions();
+    void createShortcutAction(const Akonadi::Collection &col, const QKeySequence &shortcut);
     QHash< Akonadi::Collection::Id, FolderShortcutCommand * > mFolderShortcutCommands;
+    //Shortcuts of the collections which are not in the model yet
+    QHash< Akonadi::Collection::Id, QKeySequence > mPendingShortcuts;
+    QTimer *mPendingTimer = nullptr;
     KActionCollection *mActionCollection = nullptr;
     QWidget *mParent = nullptr;
 };
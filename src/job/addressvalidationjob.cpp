@@ -59,6 +59,21 @@ bool AddressValidationJob::isValid() const
     return mIsValid;
 }
 
+void AddressValidationJob::setInteractive(bool interactive)
+{
+    mInteractive = interactive;
+}
+
+QString AddressValidationJob::errorMessage() const
+{
+    return mErrorMessage;
+}
+
+bool AddressValidationJob::isFinished() const
+{
+    return mFinished;
+}
+
 void AddressValidationJob::slotAliasExpansionDone(KJob *job)
 {
     mIsValid = true;
@@ -67,6 +82,7 @@ void AddressValidationJob::slotAliasExpansionDone(KJob *job)
         setError(job->error());
         setErrorText(job->errorText());
         mIsValid = false;
+        mFinished = true;
         emitResult();
         return;
     }
@@ -90,7 +106,7 @@ void AddressValidationJob::slotAliasExpansionDone(KJob *job)
         errorMsg = i18np("Distribution list %2 is empty, it cannot be used.",
                          "Distribution lists %2 are empty, they cannot be used.",
                          numberOfDistributionList, listOfDistributionList);
-        KMessageBox::sorry(mParentWidget, errorMsg, i18n("Invalid Email Address"));
+        mErrorMessage = errorMsg;
         mIsValid = false;
     } else {
         if (!(errorCode == KEmailAddress::AddressOk
@@ -99,10 +115,14 @@ void AddressValidationJob::slotAliasExpansionDone(KJob *job)
                                    +QLatin1String("</b></p><p>")
                                    +KEmailAddress::emailParseResultToString(errorCode)
                                    +QLatin1String("</p></qt>"));
-            KMessageBox::sorry(mParentWidget, errorMsg, i18n("Invalid Email Address"));
+            mErrorMessage = errorMsg;
             mIsValid = false;
         }
     }
 
+    if (mInteractive && !mErrorMessage.isEmpty()) {
+        KMessageBox::sorry(mParentWidget, mErrorMessage, i18n("Invalid Email Address"));
+    }
+    mFinished = true;
     emitResult();
 }
@@ -39,11 +39,22 @@ public:
 
     void setDefaultDomain(const QString &domainName);
 
+    /**
+     * When not interactive, errors are not shown but kept in errorMessage(),
+     * e.g. to validate the addresses while the user answers other questions.
+     */
+    void setInteractive(bool interactive);
+    Q_REQUIRED_RESULT QString errorMessage() const;
+    Q_REQUIRED_RESULT bool isFinished() const;
+
 private:
     void slotAliasExpansionDone(KJob *);
     QString mEmailAddresses;
     QString mDomainDefaultName;
+    QString mErrorMessage;
     bool mIsValid = false;
+    bool mInteractive = true;
+    bool mFinished = false;
     QWidget *mParentWidget = nullptr;
 };
 
@@ -0,0 +1,256 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "recoverdeadlettersjob.h"
+#include "editor/composer.h"
+#include "editor/composerautosaver.h"
+#include "kmail_debug.h"
+
+#include <KLocalizedString>
+#include <KMessageBox>
+#include <KMime/Message>
+#include <kmime/kmime_util.h>
+#include <KNotification>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QLocale>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+
+//Subjects listed in the notification, the others are only counted
+static const int s_maximumListedMessages = 5;
+
+namespace KMail {
+class DeadLettersScanner : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    DeadLettersScanner()
+        : mStartTime(QDateTime::currentDateTime())
+    {
+        //Deleted from the UI thread once done() was delivered
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        QDir dir(ComposerAutoSaver::autoSaveDirectory());
+        const QFileInfoList autoSaveFiles = dir.entryInfoList(QDir::Files);
+        for (const QFileInfo &info : autoSaveFiles) {
+            //Saved by a composer opened since the start, e.g. from the command line
+            if (info.lastModified() >= mStartTime) {
+                continue;
+            }
+            //Only the headers are needed to describe the message, stop at the body
+            QFile file(info.absoluteFilePath());
+            if (!file.open(QIODevice::ReadOnly)) {
+                qCWarning(KMAIL_LOG) << "Failed to open autosave file" << info.absoluteFilePath() << file.errorString();
+                continue;
+            }
+            QByteArray head;
+            while (!file.atEnd()) {
+                const QByteArray line = file.readLine();
+                if (line == "\n" || line == "\r\n") {
+                    break;
+                }
+                head += line;
+            }
+            KMime::Message message;
+            message.setHead(KMime::CRLFtoLF(head));
+            message.parse();
+
+            fileNames.append(info.fileName());
+            subjects.append(message.subject()->asUnicodeString());
+            dates.append(info.lastModified());
+        }
+        Q_EMIT done();
+    }
+
+    QStringList fileNames;
+    QStringList subjects;
+    QVector<QDateTime> dates;
+
+Q_SIGNALS:
+    void done();
+
+private:
+    const QDateTime mStartTime;
+};
+
+class DeadLettersLoader : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    explicit DeadLettersLoader(const QStringList &fileNames)
+        : mFileNames(fileNames)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        for (const QString &fileName : qAsConst(mFileNames)) {
+            QFile file(ComposerAutoSaver::autoSaveDirectory() + fileName);
+            if (!file.open(QIODevice::ReadOnly)) {
+                errors.append(qMakePair(file.fileName(), file.errorString()));
+                continue;
+            }
+            const KMime::Message::Ptr message(new KMime::Message());
+            message->setContent(file.readAll());
+            message->parse();
+            messages.append(qMakePair(fileName, message));
+        }
+        Q_EMIT done();
+    }
+
+    QVector<QPair<QString, KMime::Message::Ptr> > messages;
+    QVector<QPair<QString, QString> > errors;
+
+Q_SIGNALS:
+    void done();
+
+private:
+    const QStringList mFileNames;
+};
+}
+
+RecoverDeadLettersJob::RecoverDeadLettersJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+RecoverDeadLettersJob::~RecoverDeadLettersJob()
+{
+    //A running worker deletes itself once it is done
+    if (mScanner) {
+        disconnect(mScanner, nullptr, this, nullptr);
+        connect(mScanner, &KMail::DeadLettersScanner::done, mScanner, &QObject::deleteLater);
+    }
+    if (mLoader) {
+        disconnect(mLoader, nullptr, this, nullptr);
+        connect(mLoader, &KMail::DeadLettersLoader::done, mLoader, &QObject::deleteLater);
+    }
+}
+
+void RecoverDeadLettersJob::start()
+{
+    if (!QDir(KMail::ComposerAutoSaver::autoSaveDirectory()).exists()) {
+        deleteLater();
+        return;
+    }
+    mScanner = new KMail::DeadLettersScanner;
+    connect(mScanner, &KMail::DeadLettersScanner::done, this, &RecoverDeadLettersJob::slotScanDone);
+    QThreadPool::globalInstance()->start(mScanner);
+}
+
+void RecoverDeadLettersJob::slotScanDone()
+{
+    mFileNames = mScanner->fileNames;
+    const QStringList subjects = mScanner->subjects;
+    const QVector<QDateTime> dates = mScanner->dates;
+    mScanner->deleteLater();
+    mScanner = nullptr;
+
+    if (mFileNames.isEmpty()) {
+        deleteLater();
+        return;
+    }
+
+    const int count = mFileNames.count();
+    QStringList descriptions;
+    for (int i = 0; i < count && i < s_maximumListedMessages; ++i) {
+        const QString subject = subjects.at(i).isEmpty() ? i18n("(No subject)") : subjects.at(i);
+        descriptions.append(i18nc("subject (date of the last autosave)", "%1 (%2)", subject,
+                                  QLocale().toString(dates.at(i), QLocale::ShortFormat)).toHtmlEscaped());
+    }
+    if (count > s_maximumListedMessages) {
+        descriptions.append(i18np("and one more message", "and %1 more messages", count - s_maximumListedMessages));
+    }
+
+    mNotification = new KNotification(QStringLiteral("recoverdeadletters"), nullptr, KNotification::Persistent);
+    mNotification->setTitle(i18np("Unsent Message Found", "Unsent Messages Found", count));
+    mNotification->setText(i18np("A message was still being written when KMail was closed:<br/>%2",
+                                 "%1 messages were still being written when KMail was closed:<br/>%2",
+                                 count, descriptions.join(QLatin1String("<br/>"))));
+    mNotification->setActions(QStringList() << i18np("Restore Message", "Restore Messages", count));
+    connect(mNotification, QOverload<unsigned int>::of(&KNotification::activated), this, &RecoverDeadLettersJob::slotActivateNotificationAction);
+    connect(mNotification, &KNotification::closed, this, &RecoverDeadLettersJob::slotNotificationClosed);
+    mNotification->sendEvent();
+}
+
+void RecoverDeadLettersJob::slotActivateNotificationAction(unsigned int index)
+{
+    //Index == 0 => is the default action, restore too.
+    switch (index) {
+    case 0:
+    case 1:
+        restoreDeadLetters();
+        return;
+    }
+    qCWarning(KMAIL_LOG) << " RecoverDeadLettersJob::slotActivateNotificationAction unknown index " << index;
+}
+
+void RecoverDeadLettersJob::slotNotificationClosed()
+{
+    mNotification = nullptr;
+    //Not restored: the autosave files are kept and offered again on next start
+    if (!mLoader) {
+        deleteLater();
+    }
+}
+
+void RecoverDeadLettersJob::restoreDeadLetters()
+{
+    if (mLoader) {
+        return;
+    }
+    mLoader = new KMail::DeadLettersLoader(mFileNames);
+    connect(mLoader, &KMail::DeadLettersLoader::done, this, &RecoverDeadLettersJob::slotLoadDone);
+    QThreadPool::globalInstance()->start(mLoader);
+    if (mNotification) {
+        mNotification->close();
+    }
+}
+
+void RecoverDeadLettersJob::slotLoadDone()
+{
+    const auto messages = mLoader->messages;
+    const auto errors = mLoader->errors;
+    mLoader->deleteLater();
+    mLoader = nullptr;
+
+    for (const auto &deadLetter : messages) {
+        // Show the a new composer dialog for the message
+        KMail::Composer *autoSaveWin = KMail::makeComposer();
+        autoSaveWin->setMessage(deadLetter.second, false, false, false);
+        autoSaveWin->setAutoSaveFileName(deadLetter.first);
+        KMail::ComposerAutoSaver::restoreAttachments(deadLetter.first, autoSaveWin);
+        autoSaveWin->show();
+    }
+    for (const auto &error : errors) {
+        KMessageBox::sorry(nullptr, i18n("Failed to open autosave file at %1.\nReason: %2", error.first, error.second),
+                           i18n("Opening Autosave File Failed"));
+    }
+    deleteLater();
+}
+
+#include "recoverdeadlettersjob.moc"
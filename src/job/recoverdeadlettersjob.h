@@ -0,0 +1,62 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef RECOVERDEADLETTERSJOB_H
+#define RECOVERDEADLETTERSJOB_H
+
+#include <QObject>
+#include <QStringList>
+
+class KNotification;
+namespace KMail {
+class DeadLettersScanner;
+class DeadLettersLoader;
+}
+
+/**
+ * @brief The RecoverDeadLettersJob class
+ * Looks for the messages autosaved by composers which were not closed, e.g.
+ * after a crash. The autosave files are read from a thread, the user is told
+ * about them with a notification and composers are only opened if they ask for
+ * it. Messages which are not restored are offered again on next start.
+ */
+class RecoverDeadLettersJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RecoverDeadLettersJob(QObject *parent = nullptr);
+    ~RecoverDeadLettersJob() override;
+
+    void start();
+
+private:
+    Q_DISABLE_COPY(RecoverDeadLettersJob)
+    void slotScanDone();
+    void slotLoadDone();
+    void slotActivateNotificationAction(unsigned int index);
+    void slotNotificationClosed();
+    void restoreDeadLetters();
+
+    QStringList mFileNames;
+    KMail::DeadLettersScanner *mScanner = nullptr;
+    KMail::DeadLettersLoader *mLoader = nullptr;
+    KNotification *mNotification = nullptr;
+};
+
+#endif // RECOVERDEADLETTERSJOB_H
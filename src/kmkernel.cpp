@@ -32,6 +32,14 @@ using KPIM::RecentAddresses;
 #include "mailfilteragentinterface.h"
 #include <PimCommon/PimUtil>
 #include "folderarchive/folderarchivemanager.h"
+#include "expire/expiremanager.h"
+#include "collectionindex.h"
+#include "maintenancescheduler.h"
+#include "messageprefetcher.h"
+#include "startuptracer.h"
+#include "editor/recipientkeycache.h"
+#include "job/recoverdeadlettersjob.h"
+#include "editor/composerpool.h"
 #include "sieveimapinterface/kmailsieveimapinstanceinterface.h"
 // kdepim includes
 #include "kmail-version.h"
@@ -97,6 +105,7 @@ using KMail::MailServiceImpl;
 #include <QDir>
 #include <QWidget>
 #include <QFileInfo>
+#include <QTimer>
 #include <QtDBus>
 
 #include <MailCommon/ResourceReadConfigFile>
@@ -123,6 +132,8 @@ using KMail::MailServiceImpl;
 using namespace MailCommon;
 
 static KMKernel *mySelf = nullptr;
+//Leave the time to show the first window before creating what it doesn't need
+static const int s_deferredInitDelay = 2000;
 static bool s_askingToGoOnline = false;
 /********************************************************************/
 /*                     Constructor and destructor                   */
@@ -130,6 +141,7 @@ static bool s_askingToGoOnline = false;
 KMKernel::KMKernel(QObject *parent)
     : QObject(parent)
 {
+    KMail::StartupTraceScope traceScope("KMKernel");
     //Initialize kmail sieveimap interface
     KSieveUi::SieveImapInstanceInterfaceManager::self()->setSieveImapInstanceInterface(new KMailSieveImapInstanceInterface);
     mDebug = !qEnvironmentVariableIsEmpty("KDEPIM_DEBUGGING");
@@ -149,12 +161,14 @@ KMKernel::KMKernel(QObject *parent)
     the_undoStack = nullptr;
     the_msgSender = nullptr;
     mFilterEditDialog = nullptr;
+    KMail::StartupTracer::begin("loadConfig");
     // make sure that we check for config updates before doing anything else
     KMKernel::config();
     // this shares the kmailrc parsing too (via KSharedConfig), and reads values from it
     // so better do it here, than in some code where changing the group of config()
     // would be unexpected
     KMailSettings::self();
+    KMail::StartupTracer::end("loadConfig");
 
     mJobScheduler = new JobScheduler(this);
 
@@ -191,6 +205,12 @@ KMKernel::KMKernel(QObject *parent)
     mEntityTreeModel = new Akonadi::EntityTreeModel(folderCollectionMonitor(), this);
     mEntityTreeModel->setListFilter(Akonadi::CollectionFetchScope::Enabled);
     mEntityTreeModel->setItemPopulationStrategy(Akonadi::EntityTreeModel::LazyPopulation);
+    if (KMail::StartupTracer::isEnabled()) {
+        KMail::StartupTracer::begin("collectionTreeFetch");
+        connect(mEntityTreeModel, &Akonadi::EntityTreeModel::collectionTreeFetched, this, []() {
+            KMail::StartupTracer::end("collectionTreeFetch");
+        });
+    }
 
     mCollectionModel = new Akonadi::EntityMimeTypeFilterModel(this);
     mCollectionModel->setSourceModel(mEntityTreeModel);
@@ -198,6 +218,7 @@ KMKernel::KMKernel(QObject *parent)
     mCollectionModel->setHeaderGroup(Akonadi::EntityTreeModel::CollectionTreeHeaders);
     mCollectionModel->setDynamicSortFilter(true);
     mCollectionModel->setSortCaseSensitivity(Qt::CaseInsensitive);
+    mCollectionIndex = new KMail::CollectionIndex(mCollectionModel, this);
 
     connect(folderCollectionMonitor(), qOverload<const Akonadi::Collection &, const QSet<QByteArray> &>(&Akonadi::ChangeRecorder::collectionChanged), this,
             &KMKernel::slotCollectionChanged);
@@ -228,10 +249,12 @@ KMKernel::KMKernel(QObject *parent)
     CommonKernel->registerKernelIf(this);
     CommonKernel->registerSettingsIf(this);
     CommonKernel->registerFilterIf(this);
-    mFolderArchiveManager = new FolderArchiveManager(this);
-    mIndexedItems = new Akonadi::Search::PIM::IndexedItems(this);
-    mCheckIndexingManager = new CheckIndexingManager(mIndexedItems, this);
-    mUnityServiceManager = new KMail::UnityServiceManager(this);
+    mExpireManager = new ExpireManager(this);
+    mMessagePrefetcher = new KMail::MessagePrefetcher(this);
+    mComposerPool = new KMail::ComposerPool(this);
+    setupMaintenanceTasks();
+    //The folder archive manager, the index check, the indexer interface and
+    //the unread count (tray, launcher) are created on first use or in slotDeferredInit()
 }
 
 KMKernel::~KMKernel()
@@ -729,14 +752,16 @@ bool KMKernel::showMail(qint64 serialNumber)
 
 void KMKernel::pauseBackgroundJobs()
 {
-    mBackgroundTasksTimer->stop();
+    mMaintenanceScheduler->pause();
     mJobScheduler->pause();
+    mExpireManager->pause();
 }
 
 void KMKernel::resumeBackgroundJobs()
 {
     mJobScheduler->resume();
-    mBackgroundTasksTimer->start(4 * 60 * 60 * 1000);
+    mExpireManager->resume();
+    mMaintenanceScheduler->resume();
 }
 
 void KMKernel::stopNetworkJobs()
@@ -827,6 +852,7 @@ bool KMKernel::isOffline()
 
 void KMKernel::verifyAccount()
 {
+    KMail::StartupTraceScope traceScope("verifyAccounts");
     const QString resourceGroupPattern(QStringLiteral("Resource %1"));
 
     const Akonadi::AgentInstance::List lst = MailCommon::Util::agentInstances();
@@ -978,42 +1004,9 @@ void KMKernel::slotSenderFinished()
 // Open a composer for each message found in the dead.letter folder
 void KMKernel::recoverDeadLetters()
 {
-    const QString pathName = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String("/kmail2/");
-    QDir dir(pathName);
-    if (!dir.exists(QStringLiteral("autosave"))) {
-        return;
-    }
-
-    dir.cd(pathName + QLatin1String("autosave"));
-    const QFileInfoList autoSaveFiles = dir.entryInfoList();
-    for (const QFileInfo &file : autoSaveFiles) {
-        // Disregard the '.' and '..' folders
-        const QString filename = file.fileName();
-        if (filename == QLatin1Char('.')
-            || filename == QLatin1String("..")
-            || file.isDir()) {
-            continue;
-        }
-        qCDebug(KMAIL_LOG) << "Opening autosave file:" << file.absoluteFilePath();
-        QFile autoSaveFile(file.absoluteFilePath());
-        if (autoSaveFile.open(QIODevice::ReadOnly)) {
-            const KMime::Message::Ptr autoSaveMessage(new KMime::Message());
-            const QByteArray msgData = autoSaveFile.readAll();
-            autoSaveMessage->setContent(msgData);
-            autoSaveMessage->parse();
-
-            // Show the a new composer dialog for the message
-            KMail::Composer *autoSaveWin = KMail::makeComposer();
-            autoSaveWin->setMessage(autoSaveMessage, false, false, false);
-            autoSaveWin->setAutoSaveFileName(filename);
-            autoSaveWin->show();
-            autoSaveFile.close();
-        } else {
-            KMessageBox::sorry(nullptr, i18n("Failed to open autosave file at %1.\nReason: %2",
-                                             file.absoluteFilePath(), autoSaveFile.errorString()),
-                               i18n("Opening Autosave File Failed"));
-        }
-    }
+    //Reading the autosave files can take a while, don't hold up the startup
+    RecoverDeadLettersJob *job = new RecoverDeadLettersJob(this);
+    job->start();
 }
 
 void KMKernel::akonadiStateChanged(Akonadi::ServerManager::State state)
@@ -1021,6 +1014,8 @@ void KMKernel::akonadiStateChanged(Akonadi::ServerManager::State state)
     qCDebug(KMAIL_LOG) << "KMKernel has akonadi state changed to:" << int(state);
 
     if (state == Akonadi::ServerManager::Running) {
+        KMail::StartupTracer::end("akonadiServerStart");
+        KMail::StartupTraceScope traceScope("initFolders");
         CommonKernel->initFolders();
     }
 }
@@ -1049,20 +1044,22 @@ void KMKernel::init()
     the_msgSender = new MessageComposer::AkonadiSender;
     // filterMgr->dump();
 
-    mBackgroundTasksTimer = new QTimer(this);
-    mBackgroundTasksTimer->setSingleShot(true);
-    connect(mBackgroundTasksTimer, &QTimer::timeout, this, &KMKernel::slotRunBackgroundTasks);
 #ifdef DEBUG_SCHEDULER // for debugging, see jobscheduler.h
-    mBackgroundTasksTimer->start(10000);   // 10s, singleshot
+    mMaintenanceScheduler->start(10000);   // 10s
 #else
-    mBackgroundTasksTimer->start(5 * 60000);   // 5 minutes, singleshot
+    mMaintenanceScheduler->start(5 * 60000);   // 5 minutes
 #endif
 
     KCrash::setEmergencySaveFunction(kmCrashHandler);
 
+    QTimer::singleShot(s_deferredInitDelay, this, &KMKernel::slotDeferredInit);
+
     qCDebug(KMAIL_LOG) << "KMail init with akonadi server state:" << int(Akonadi::ServerManager::state());
     if (Akonadi::ServerManager::state() == Akonadi::ServerManager::Running) {
+        KMail::StartupTraceScope traceScope("initFolders");
         CommonKernel->initFolders();
+    } else {
+        KMail::StartupTracer::begin("akonadiServerStart");
     }
 
     connect(Akonadi::ServerManager::self(), &Akonadi::ServerManager::stateChanged, this, &KMKernel::akonadiStateChanged);
@@ -1209,7 +1206,9 @@ void KMKernel::slotSyncConfig()
     Gravatar::GravatarSettings::self()->load();
     KMailSettings::self()->load();
     KMKernel::config()->reparseConfiguration();
-    mUnityServiceManager->updateCount();
+    if (mUnityServiceManager) {
+        mUnityServiceManager->updateCount();
+    }
 }
 
 void KMKernel::saveConfig()
@@ -1268,7 +1267,8 @@ void KMKernel::slotConfigChanged()
 
 bool KMKernel::haveSystemTrayApplet() const
 {
-    return mUnityServiceManager->haveSystemTrayApplet();
+    //The tray is created with the unread count manager
+    return mUnityServiceManager && mUnityServiceManager->haveSystemTrayApplet();
 }
 
 QTextCodec *KMKernel::networkCodec() const
@@ -1278,7 +1278,7 @@ QTextCodec *KMKernel::networkCodec() const
 
 void KMKernel::updateSystemTray()
 {
-    if (!the_shuttingDown) {
+    if (!the_shuttingDown && mUnityServiceManager) {
         mUnityServiceManager->initListOfCollection();
     }
 }
@@ -1404,60 +1404,72 @@ KMMainWidget *KMKernel::getKMMainWidget()
     return nullptr;
 }
 
-void KMKernel::slotRunBackgroundTasks() // called regularly by timer
+void KMKernel::setupMaintenanceTasks()
 {
-    // Hidden KConfig keys. Not meant to be used, but a nice fallback in case
-    // a stable kmail release goes out with a nasty bug in CompactionJob...
-    if (KMailSettings::self()->autoExpiring()) {
-        mFolderCollectionMonitor->expireAllFolders(false /*scheduled, not immediate*/, entityTreeModel());
-    }
-    if (KMailSettings::self()->checkCollectionsIndexing()) {
-        mCheckIndexingManager->start(entityTreeModel());
-    }
 #ifdef DEBUG_SCHEDULER // for debugging, see jobscheduler.h
-    mBackgroundTasksTimer->start(60 * 1000);   // check again in 1 minute
+    const int interval = 60;   // 1 minute
 #else
-    mBackgroundTasksTimer->start(4 * 60 * 60 * 1000);   // check again in 4 hours
+    const int interval = 4 * 60 * 60;   // 4 hours
 #endif
-}
+    mMaintenanceScheduler = new KMail::MaintenanceScheduler(this);
 
-static Akonadi::Collection::List collect_collections(const QAbstractItemModel *model, const QModelIndex &parent)
-{
-    Akonadi::Collection::List collections;
-    QStack<QModelIndex> stack;
-    stack.push(parent);
-    while (!stack.isEmpty()) {
-        const QModelIndex idx = stack.pop();
-        if (idx.isValid()) {
-            collections << model->data(idx, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
-            for (int i = model->rowCount(idx) - 1; i >= 0; --i) {
-                stack.push(model->index(i, 0, idx));
-            }
+    // Hidden KConfig keys. Not meant to be used, but a nice fallback in case
+    // a stable kmail release goes out with a nasty bug in CompactionJob...
+    KMail::MaintenanceScheduler::Task expireTask;
+    expireTask.name = QStringLiteral("expireFolders");
+    expireTask.cost = KMail::MaintenanceScheduler::HeavyTask;
+    expireTask.interval = interval;
+    expireTask.start = [this]() {
+        if (!KMailSettings::self()->autoExpiring()) {
+            return false;
         }
-    }
-
-    return collections;
+        mExpireManager->start(allFolders(), false /*scheduled, not immediate*/);
+        return mExpireManager->isRunning();
+    };
+    expireTask.pause = [this]() {
+        mExpireManager->pause();
+    };
+    expireTask.resume = [this]() {
+        mExpireManager->resume();
+    };
+    mMaintenanceScheduler->addTask(expireTask);
+    connect(mExpireManager, &ExpireManager::finished, this, [this]() {
+        mMaintenanceScheduler->taskFinished(QStringLiteral("expireFolders"));
+    });
+
+    KMail::MaintenanceScheduler::Task indexingTask;
+    indexingTask.name = QStringLiteral("checkIndexing");
+    indexingTask.cost = KMail::MaintenanceScheduler::HeavyTask;
+    indexingTask.interval = interval;
+    indexingTask.start = [this]() {
+        if (!KMailSettings::self()->checkCollectionsIndexing()) {
+            return false;
+        }
+        checkIndexingManager()->start(entityTreeModel());
+        return mCheckIndexingManager->isRunning();
+    };
+    indexingTask.pause = [this]() {
+        mCheckIndexingManager->pause();
+    };
+    indexingTask.resume = [this]() {
+        mCheckIndexingManager->resume();
+    };
+    mMaintenanceScheduler->addTask(indexingTask);
 }
 
 Akonadi::Collection::List KMKernel::allFolders() const
 {
-    return collect_collections(collectionModel(), QModelIndex());
+    return mCollectionIndex->collections();
 }
 
 Akonadi::Collection::List KMKernel::subfolders(const Akonadi::Collection &col) const
 {
-    const auto idx = collectionModel()->match({}, Akonadi::EntityTreeModel::CollectionRole,
-                                              QVariant::fromValue(col), 1, Qt::MatchExactly);
-    if (!idx.isEmpty()) {
-        return collect_collections(collectionModel(), idx[0]);
-    }
-
-    return {};
+    return mCollectionIndex->subtree(col.id());
 }
 
 void KMKernel::expireAllFoldersNow() // called by the GUI
 {
-    mFolderCollectionMonitor->expireAllFolders(true /*immediate*/, entityTreeModel());
+    mExpireManager->start(allFolders(), true /*immediate*/);
 }
 
 bool KMKernel::canQueryClose()
@@ -1466,7 +1478,7 @@ bool KMKernel::canQueryClose()
         && KMMainWidget::mainWidgetList()->count() > 1) {
         return true;
     }
-    return mUnityServiceManager->canQueryClose();
+    return !mUnityServiceManager || mUnityServiceManager->canQueryClose();
 }
 
 Akonadi::Collection KMKernel::currentCollection()
@@ -1494,11 +1506,45 @@ MailCommon::MailCommonSettings *KMKernel::mailCommonSettings() const
     return mMailCommonSettings;
 }
 
-Akonadi::Search::PIM::IndexedItems *KMKernel::indexedItems() const
+Akonadi::Search::PIM::IndexedItems *KMKernel::indexedItems()
 {
+    if (!mIndexedItems) {
+        mIndexedItems = new Akonadi::Search::PIM::IndexedItems(this);
+    }
     return mIndexedItems;
 }
 
+CheckIndexingManager *KMKernel::checkIndexingManager()
+{
+    if (!mCheckIndexingManager) {
+        mCheckIndexingManager = new CheckIndexingManager(indexedItems(), this);
+        connect(folderCollectionMonitor(), &Akonadi::Monitor::collectionStatisticsChanged,
+                mCheckIndexingManager, &CheckIndexingManager::collectionStatisticsChanged);
+        connect(mCheckIndexingManager, &CheckIndexingManager::finished, this, [this]() {
+            mMaintenanceScheduler->taskFinished(QStringLiteral("checkIndexing"));
+        });
+    }
+    return mCheckIndexingManager;
+}
+
+KMail::UnityServiceManager *KMKernel::unityServiceManager()
+{
+    if (!mUnityServiceManager) {
+        mUnityServiceManager = new KMail::UnityServiceManager(this);
+    }
+    return mUnityServiceManager;
+}
+
+void KMKernel::slotDeferredInit()
+{
+    if (the_shuttingDown) {
+        return;
+    }
+    //Unread count in the launcher, and the order of the next index check
+    unityServiceManager();
+    checkIndexingManager();
+}
+
 // can't be inline, since KMSender isn't known to implement
 // KMail::MessageSender outside this .cpp file
 MessageComposer::MessageSender *KMKernel::msgSender()
@@ -1715,6 +1761,7 @@ void KMKernel::slotCollectionRemoved(const Akonadi::Collection &col)
     const QString colStr = QString::number(col.id());
     TemplateParser::Util::deleteTemplate(colStr);
     MessageList::Util::deleteConfig(colStr);
+    folderArchiveManager()->slotCollectionRemoved(col);
 }
 
 void KMKernel::slotDeleteIdentity(uint identity)
@@ -1852,7 +1899,7 @@ void KMKernel::slotInstanceRemoved(const Akonadi::AgentInstance &instance)
     if (mResourceCryptoSettingCache.contains(identifier)) {
         mResourceCryptoSettingCache.remove(identifier);
     }
-    mFolderArchiveManager->slotInstanceRemoved(instance);
+    folderArchiveManager()->slotInstanceRemoved(instance);
 
     if (MailCommon::Util::isMailAgent(instance)) {
         Q_EMIT incomingAccountsChanged();
@@ -1916,7 +1963,10 @@ void KMKernel::toggleSystemTray()
 {
     KMMainWidget *widget = getKMMainWidget();
     if (widget) {
-        mUnityServiceManager->toggleSystemTray(widget);
+        //Without tray there is nothing to toggle until the unread count is needed
+        if (mUnityServiceManager || KMailSettings::self()->systemTrayEnabled()) {
+            unityServiceManager()->toggleSystemTray(widget);
+        }
     }
 }
 
@@ -1930,21 +1980,51 @@ void KMKernel::showFolder(const QString &collectionId)
 
 void KMKernel::reloadFolderArchiveConfig()
 {
-    mFolderArchiveManager->reloadConfig();
+    //Otherwise the config is read when it is created
+    if (mFolderArchiveManager) {
+        mFolderArchiveManager->reloadConfig();
+    }
 }
 
-void KMKernel::slotCollectionChanged(const Akonadi::Collection &, const QSet<QByteArray> &set)
+void KMKernel::slotCollectionChanged(const Akonadi::Collection &collection, const QSet<QByteArray> &set)
 {
-    if (set.contains("newmailnotifierattribute")) {
-        mUnityServiceManager->initListOfCollection();
+    if (set.contains("newmailnotifierattribute") && mUnityServiceManager) {
+        mUnityServiceManager->updateCollection(collection);
     }
 }
 
-FolderArchiveManager *KMKernel::folderArchiveManager() const
+FolderArchiveManager *KMKernel::folderArchiveManager()
 {
+    if (!mFolderArchiveManager) {
+        mFolderArchiveManager = new FolderArchiveManager(this);
+    }
     return mFolderArchiveManager;
 }
 
+ExpireManager *KMKernel::expireManager() const
+{
+    return mExpireManager;
+}
+
+KMail::MessagePrefetcher *KMKernel::messagePrefetcher() const
+{
+    return mMessagePrefetcher;
+}
+
+KMail::ComposerPool *KMKernel::composerPool() const
+{
+    return mComposerPool;
+}
+
+KMail::RecipientKeyCache *KMKernel::recipientKeyCache()
+{
+    //Only needed once a composer looks up keys, avoid loading the key cache at startup
+    if (!mRecipientKeyCache) {
+        mRecipientKeyCache = new KMail::RecipientKeyCache(this);
+    }
+    return mRecipientKeyCache;
+}
+
 bool KMKernel::allowToDebug() const
 {
     return mDebug;
@@ -56,6 +56,11 @@ namespace KMail {
 class MailServiceImpl;
 class UndoStack;
 class UnityServiceManager;
+class MessagePrefetcher;
+class RecipientKeyCache;
+class ComposerPool;
+class MaintenanceScheduler;
+class CollectionIndex;
 }
 namespace MessageComposer {
 class AkonadiSender;
@@ -88,6 +93,7 @@ class KMMainWidget;
 class ConfigureDialog;
 class FolderArchiveManager;
 class CheckIndexingManager;
+class ExpireManager;
 
 /**
  * @short Central point of coordination in KMail
@@ -409,11 +415,15 @@ public:
     PimCommon::AutoCorrection *composerAutoCorrection();
 
     void toggleSystemTray();
-    FolderArchiveManager *folderArchiveManager() const;
+    FolderArchiveManager *folderArchiveManager();
+    ExpireManager *expireManager() const;
+    KMail::MessagePrefetcher *messagePrefetcher() const;
+    KMail::RecipientKeyCache *recipientKeyCache();
+    KMail::ComposerPool *composerPool() const;
 
     bool allowToDebug() const;
 
-    Akonadi::Search::PIM::IndexedItems *indexedItems() const;
+    Akonadi::Search::PIM::IndexedItems *indexedItems();
 
     void cleanupTemporaryFiles();
     MailCommon::MailCommonSettings *mailCommonSettings() const;
@@ -447,7 +457,6 @@ public Q_SLOTS:
     void slotSyncConfig();
 
     void slotShowConfigurationDialog();
-    void slotRunBackgroundTasks();
 
     void slotConfigChanged();
 Q_SIGNALS:
@@ -469,6 +478,7 @@ private Q_SLOTS:
 
     void akonadiStateChanged(Akonadi::ServerManager::State);
     void slotProgressItemCompletedOrCanceled(KPIM::ProgressItem *item);
+    void slotDeferredInit();
     void slotInstanceError(const Akonadi::AgentInstance &instance, const QString &message);
     void slotInstanceWarning(const Akonadi::AgentInstance &instance, const QString &message);
     void slotCollectionRemoved(const Akonadi::Collection &col);
@@ -482,6 +492,9 @@ private Q_SLOTS:
 private:
     void viewMessage(const QUrl &url);
     Akonadi::Collection currentCollection();
+    void setupMaintenanceTasks();
+    CheckIndexingManager *checkIndexingManager();
+    KMail::UnityServiceManager *unityServiceManager();
 
     /*
      * Fills a composer cWin
@@ -510,7 +523,6 @@ private:
     QString mXmlGuiInstance;
     ConfigureDialog *mConfigureDialog = nullptr;
 
-    QTimer *mBackgroundTasksTimer = nullptr;
     MailCommon::JobScheduler *mJobScheduler = nullptr;
     KMail::MailServiceImpl *mMailService = nullptr;
 
@@ -521,6 +533,7 @@ private:
     MailCommon::FolderCollectionMonitor *mFolderCollectionMonitor = nullptr;
     Akonadi::EntityTreeModel *mEntityTreeModel = nullptr;
     Akonadi::EntityMimeTypeFilterModel *mCollectionModel = nullptr;
+    KMail::CollectionIndex *mCollectionIndex = nullptr;
 
     /// List of Akonadi resources that are currently being checked.
     QStringList mResourcesBeingChecked;
@@ -529,6 +542,11 @@ private:
     PimCommon::AutoCorrection *mAutoCorrection = nullptr;
     FolderArchiveManager *mFolderArchiveManager = nullptr;
     CheckIndexingManager *mCheckIndexingManager = nullptr;
+    ExpireManager *mExpireManager = nullptr;
+    KMail::MessagePrefetcher *mMessagePrefetcher = nullptr;
+    KMail::RecipientKeyCache *mRecipientKeyCache = nullptr;
+    KMail::ComposerPool *mComposerPool = nullptr;
+    KMail::MaintenanceScheduler *mMaintenanceScheduler = nullptr;
     Akonadi::Search::PIM::IndexedItems *mIndexedItems = nullptr;
     MailCommon::MailCommonSettings *mMailCommonSettings = nullptr;
 #ifdef WITH_KUSERFEEDBACK
@@ -30,6 +30,7 @@
 #include "undostack.h"
 #include "kmcommands.h"
 #include "kmmainwin.h"
+#include "messageprefetcher.h"
 #include <TemplateParser/CustomTemplatesMenu>
 #include <MailCommon/FolderSelectionDialog>
 #include <MailCommon/FolderTreeWidget>
@@ -65,6 +66,8 @@
 #include "job/createnewcontactjob.h"
 #include "folderarchive/folderarchiveutil.h"
 #include "folderarchive/folderarchivemanager.h"
+#include "expire/expiremanager.h"
+#include "startuptracer.h"
 
 #include <PimCommonAkonadi/CollectionAclPage>
 #include <PimCommon/PimUtil>
@@ -216,6 +219,7 @@ KMMainWidget::KMMainWidget(QWidget *parent, KXMLGUIClient *aGUIClient, KActionCo
     : QWidget(parent)
     , mManageShowCollectionProperties(new ManageShowCollectionProperties(this, this))
 {
+    KMail::StartupTraceScope traceScope("KMMainWidget");
     mLaunchExternalComponent = new KMLaunchExternalComponent(this, this);
     // must be the first line of the constructor:
     mStartupDone = false;
@@ -1030,6 +1034,10 @@ void KMMainWidget::createWidgets()
     mMessagePane = new CollectionPane(!KMailSettings::self()->startSpecificFolderAtStartup(), KMKernel::self()->entityTreeModel(),
                                       mFolderTreeWidget->folderTreeView()->selectionModel(),
                                       this);
+    if (KMail::StartupTracer::isEnabled()) {
+        KMail::StartupTracer::begin("messageListFirstPaint");
+        KMail::StartupTracer::endOnFirstPaint("messageListFirstPaint", mMessagePane);
+    }
     connect(KMKernel::self()->entityTreeModel(), &Akonadi::EntityTreeModel::collectionFetched, this, &KMMainWidget::slotCollectionFetched);
 
     mMessagePane->setXmlGuiClient(mGUIClient);
@@ -1465,7 +1473,7 @@ void KMMainWidget::slotExpireFolder()
             }
         }
 
-        MailCommon::Util::expireOldMessages(mCurrentCollection, true /*immediate*/);
+        kmkernel->expireManager()->start({mCurrentCollection}, true /*immediate*/);
     }
 }
 
@@ -2579,6 +2587,12 @@ void KMMainWidget::slotMessageActivated(const Akonadi::Item &msg)
         return;
     }
 
+    const Akonadi::Item cachedItem = kmkernel->messagePrefetcher()->cachedItem(msg);
+    if (cachedItem.isValid()) {
+        showMessageInReaderWindow(cachedItem, nullptr);
+        return;
+    }
+
     KMReaderMainWin *win = nullptr;
     if (!mMsgView) {
         win = new KMReaderMainWin(mFolderDisplayFormatPreference, mFolderHtmlLoadExtPreference);
@@ -2599,9 +2613,11 @@ void KMMainWidget::slotItemsFetchedForActivation(KMCommand *command)
     }
 
     KMFetchMessageCommand *fetchCmd = qobject_cast<KMFetchMessageCommand *>(command);
-    const Item msg = fetchCmd->item();
-    KMReaderMainWin *win = fetchCmd->readerMainWin();
+    showMessageInReaderWindow(fetchCmd->item(), fetchCmd->readerMainWin());
+}
 
+void KMMainWidget::showMessageInReaderWindow(const Akonadi::Item &msg, KMReaderMainWin *win)
+{
     if (!win) {
         win = new KMReaderMainWin(mFolderDisplayFormatPreference, mFolderHtmlLoadExtPreference);
     }
@@ -4491,6 +4507,11 @@ void KMMainWidget::slotMessageSelected(const Akonadi::Item &item)
         if (!item.isValid()) {
             mMsgView->clear();
         } else {
+            const Akonadi::Item cachedItem = kmkernel->messagePrefetcher()->cachedItem(item);
+            if (cachedItem.isValid()) {
+                itemsReceived({cachedItem});
+                return;
+            }
             mShowBusySplashTimer = new QTimer(this);
             mShowBusySplashTimer->setSingleShot(true);
             connect(mShowBusySplashTimer, &QTimer::timeout, this, &KMMainWidget::slotShowBusySplash);
@@ -4546,6 +4567,15 @@ void KMMainWidget::itemsReceived(const Akonadi::Item::List &list)
     assignLoadExternalReference();
     mMsgView->setDecryptMessageOverwrite(false);
     mMsgActions->setCurrentMessage(copyItem);
+    prefetchMessagesAround();
+}
+
+void KMMainWidget::prefetchMessagesAround()
+{
+    if (!mMessagePane) {
+        return;
+    }
+    kmkernel->messagePrefetcher()->prefetch(mMessagePane->itemsAroundCurrentItem(KMail::MessagePrefetcher::prefetchDistance()));
 }
 
 void KMMainWidget::itemsFetchDone(KJob *job)
@@ -64,6 +64,7 @@ class KToggleAction;
 class KMMetaFilterActionCommand;
 class CollectionPane;
 class KMCommand;
+class KMReaderMainWin;
 class KMMoveCommand;
 class KMTrashMsgCommand;
 class KRecentFilesAction;
@@ -495,6 +496,8 @@ private Q_SLOTS:
     void slotCollectionFetched(int collectionId);
 
     void itemsReceived(const Akonadi::Item::List &list);
+    void prefetchMessagesAround();
+    void showMessageInReaderWindow(const Akonadi::Item &msg, KMReaderMainWin *win);
     void itemsFetchDone(KJob *job);
 
     void slotServerSideSubscription();
@@ -25,6 +25,7 @@
 #include "settings/kmailsettings.h"
 #include "kmmainwidget.h"
 #include "kmreadermainwin.h"
+#include "messageprefetcher.h"
 #include <MailCommon/MailKernel>
 #include "dialog/addemailtoexistingcontactdialog.h"
 #include "job/addemailtoexistingcontactjob.h"
@@ -680,6 +681,7 @@ void KMReaderWin::clear(bool force)
 void KMReaderWin::setMessage(const Akonadi::Item &item, MimeTreeParser::UpdateMode updateMode)
 {
     qCDebug(KMAIL_LOG) << Q_FUNC_INFO << parentWidget();
+    kmkernel->messagePrefetcher()->insert(item);
     mViewer->setMessageItem(item, updateMode);
 }
 
@@ -26,6 +26,7 @@
 #include <MailCommon/MailKernel>
 #include <MailCommon/FolderTreeView>
 #include <Akonadi/KMime/NewMailNotifierAttribute>
+#include <AkonadiCore/EntityTreeModel>
 
 #include <KWindowSystem>
 #include "kmail_debug.h"
@@ -33,6 +34,8 @@
 #include <KLocalizedString>
 #include <QAction>
 
+#include <algorithm>
+
 #include "widgets/kactionmenutransport.h"
 
 using namespace MailCommon;
@@ -50,6 +53,8 @@ using namespace MailCommon;
  */
 using namespace KMail;
 
+static const int s_maximumFoldersInMenu = 20;
+
 KMSystemTray::KMSystemTray(QObject *parent)
     : KStatusNotifierItem(parent)
 {
@@ -143,7 +148,16 @@ void KMSystemTray::updateCount(int count)
 
 void KMSystemTray::setUnityServiceManager(UnityServiceManager *unityServiceManager)
 {
+    if (mUnityServiceManager) {
+        disconnect(mUnityServiceManager, &UnityServiceManager::unreadCollectionsChanged, this, nullptr);
+    }
     mUnityServiceManager = unityServiceManager;
+    mUnreadFoldersDirty = true;
+    if (mUnityServiceManager) {
+        connect(mUnityServiceManager, &UnityServiceManager::unreadCollectionsChanged, this, [this]() {
+            mUnreadFoldersDirty = true;
+        });
+    }
 }
 
 /**
@@ -201,7 +215,7 @@ void KMSystemTray::slotContextMenuAboutToShow()
     }
     mHasUnreadMessage = false;
     mNewMessagesPopup = new QMenu();
-    fillFoldersMenu(mNewMessagesPopup, kmkernel->treeviewModelSelection());
+    fillFoldersMenu(mNewMessagesPopup);
 
     connect(mNewMessagesPopup, &QMenu::triggered, this, &KMSystemTray::slotSelectCollection);
 
@@ -211,35 +225,56 @@ void KMSystemTray::slotContextMenuAboutToShow()
     }
 }
 
-void KMSystemTray::fillFoldersMenu(QMenu *menu, const QAbstractItemModel *model, const QString &parentName, const QModelIndex &parentIndex)
+QString KMSystemTray::folderLabel(const Akonadi::Collection &collection) const
 {
-    const int rowCount = model->rowCount(parentIndex);
-    for (int row = 0; row < rowCount; ++row) {
-        const QModelIndex index = model->index(row, 0, parentIndex);
-        const Akonadi::Collection collection = model->data(index, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
-        qint64 count = 0;
-        if (mUnityServiceManager && !mUnityServiceManager->excludeFolder(collection)) {
-            const Akonadi::CollectionStatistics statistics = collection.statistics();
-            count = qMax(0LL, statistics.unreadCount());
-            if (count > 0) {
-                if (mUnityServiceManager->ignoreNewMailInFolder(collection)) {
-                    count = 0;
-                } else {
-                    mHasUnreadMessage = true;
-                }
-            }
-        }
-        QString label = parentName.isEmpty() ? QString() : QString(parentName + QLatin1String("->"));
-        label += model->data(index).toString();
-        label.replace(QLatin1Char('&'), QStringLiteral("&&"));
-        if (count > 0) {
-            // insert an item
-            QAction *action = menu->addAction(label);
-            action->setData(collection.id());
+    const QAbstractItemModel *model = kmkernel->collectionModel();
+    QStringList names;
+    Akonadi::Collection col = collection;
+    while (col.isValid() && col != Akonadi::Collection::root()) {
+        names.prepend(col.displayName());
+        col = Akonadi::EntityTreeModel::updatedCollection(model, col.parentCollection().id());
+    }
+    return names.join(QStringLiteral("->"));
+}
+
+void KMSystemTray::updateUnreadFolders()
+{
+    mUnreadFolders.clear();
+    mUnreadFoldersDirty = false;
+    if (!mUnityServiceManager) {
+        return;
+    }
+    const QAbstractItemModel *model = kmkernel->collectionModel();
+    const QHash<Akonadi::Collection::Id, qint64> &unreadCollections = mUnityServiceManager->unreadCollections();
+    mUnreadFolders.reserve(unreadCollections.count());
+    for (auto it = unreadCollections.cbegin(), end = unreadCollections.cend(); it != end; ++it) {
+        const Akonadi::Collection collection = Akonadi::EntityTreeModel::updatedCollection(model, it.key());
+        if (collection.isValid()) {
+            mUnreadFolders.append(qMakePair(folderLabel(collection), it.key()));
         }
-        if (model->rowCount(index) > 0) {
-            fillFoldersMenu(menu, model, label, index);
+    }
+    std::sort(mUnreadFolders.begin(), mUnreadFolders.end(), [](const QPair<QString, Akonadi::Collection::Id> &left, const QPair<QString, Akonadi::Collection::Id> &right) {
+        return QString::compare(left.first, right.first, Qt::CaseInsensitive) < 0;
+    });
+}
+
+void KMSystemTray::fillFoldersMenu(QMenu *menu)
+{
+    if (mUnreadFoldersDirty) {
+        updateUnreadFolders();
+    }
+    mHasUnreadMessage = !mUnreadFolders.isEmpty();
+    QMenu *folderMenu = menu;
+    int count = 0;
+    for (const QPair<QString, Akonadi::Collection::Id> &folder : qAsConst(mUnreadFolders)) {
+        if (count == s_maximumFoldersInMenu) {
+            folderMenu = menu->addMenu(i18n("More"));
         }
+        QString label = folder.first;
+        label.replace(QLatin1Char('&'), QStringLiteral("&&"));
+        QAction *action = folderMenu->addAction(label);
+        action->setData(folder.second);
+        ++count;
     }
 }
 
@@ -22,7 +22,8 @@
 #include <KStatusNotifierItem>
 
 #include <QAction>
-#include <QAbstractItemModel>
+#include <QPair>
+#include <QVector>
 
 class QMenu;
 
@@ -56,9 +57,14 @@ private:
 
     Q_REQUIRED_RESULT bool mainWindowIsOnCurrentDesktop();
     Q_REQUIRED_RESULT bool buildPopupMenu();
-    void fillFoldersMenu(QMenu *menu, const QAbstractItemModel *model, const QString &parentName = QString(), const QModelIndex &parentIndex = QModelIndex());
+    void fillFoldersMenu(QMenu *menu);
+    void updateUnreadFolders();
+    Q_REQUIRED_RESULT QString folderLabel(const Akonadi::Collection &collection) const;
     int mDesktopOfMainWin = 0;
 
+    //Folders with unread mail sorted by label, rebuilt only when unread folders changed
+    QVector<QPair<QString, Akonadi::Collection::Id> > mUnreadFolders;
+    bool mUnreadFoldersDirty = true;
     bool mHasUnreadMessage = false;
     bool mIconNotificationsEnabled = true;
 
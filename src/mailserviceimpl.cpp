@@ -35,28 +35,31 @@
 
 // kdepim includes
 #include <MessageComposer/MessageHelper>
+#include <MessageComposer/MessageSender>
+#include <KIdentityManagement/Identity>
+#include <KIdentityManagement/IdentityManager>
+#include <MailTransport/Transport>
+#include <MailTransport/TransportManager>
 
 #include <QUrl>
 #include "kmail_debug.h"
 
+#include <QDBusArgument>
 #include <QDBusConnection>
+#include <QFile>
+#include <QFileInfo>
+#include <QMimeDatabase>
 
 using namespace KMail;
 MailServiceImpl::MailServiceImpl()
 {
     new ServiceAdaptor(this);
-    QDBusConnection::sessionBus().registerObject(QStringLiteral("/MailTransportService"), this);
+    QDBusConnection::sessionBus().registerObject(QStringLiteral("/MailTransportService"), this,
+                                                 QDBusConnection::ExportAdaptors | QDBusConnection::ExportScriptableSlots);
 }
 
-bool MailServiceImpl::sendMessage(const QString &from, const QString &to, const QString &cc, const QString &bcc, const QString &subject, const QString &body, const QStringList &attachments)
+static void fillHeaders(const KMime::Message::Ptr &msg, const QString &from, const QString &to, const QString &cc, const QString &bcc, const QString &subject)
 {
-    if (to.isEmpty() && cc.isEmpty() && bcc.isEmpty()) {
-        return false;
-    }
-
-    KMime::Message::Ptr msg(new KMime::Message);
-    MessageHelper::initHeader(msg, KMKernel::self()->identityManager());
-
     msg->contentType()->setCharset("utf-8");
 
     if (!from.isEmpty()) {
@@ -74,9 +77,33 @@ bool MailServiceImpl::sendMessage(const QString &from, const QString &to, const
     if (!subject.isEmpty()) {
         msg->subject()->fromUnicodeString(subject, "utf-8");
     }
+}
+
+static KMime::Message::Ptr createMessage(const QString &from, const QString &to, const QString &cc, const QString &bcc, const QString &subject, const QString &body)
+{
+    KMime::Message::Ptr msg(new KMime::Message);
+    MessageHelper::initHeader(msg, KMKernel::self()->identityManager());
+    fillHeaders(msg, from, to, cc, bcc, subject);
     if (!body.isEmpty()) {
         msg->setBody(body.toUtf8());
     }
+    return msg;
+}
+
+static void setKMailHeader(const KMime::Message::Ptr &msg, const char *name, const QString &value)
+{
+    auto header = new KMime::Headers::Generic(name);
+    header->fromUnicodeString(value, "utf-8");
+    msg->setHeader(header);
+}
+
+bool MailServiceImpl::sendMessage(const QString &from, const QString &to, const QString &cc, const QString &bcc, const QString &subject, const QString &body, const QStringList &attachments)
+{
+    if (to.isEmpty() && cc.isEmpty() && bcc.isEmpty()) {
+        return false;
+    }
+
+    KMime::Message::Ptr msg = createMessage(from, to, cc, bcc, subject, body);
 
     KMail::Composer *cWin = KMail::makeComposer(msg);
 
@@ -97,35 +124,103 @@ bool MailServiceImpl::sendMessage(const QString &from, const QString &to, const
         return false;
     }
 
-    KMime::Message::Ptr msg(new KMime::Message);
-    MessageHelper::initHeader(msg, KMKernel::self()->identityManager());
+    KMime::Message::Ptr msg = createMessage(from, to, cc, bcc, subject, body);
 
-    msg->contentType()->setCharset("utf-8");
+    KMime::Content *part = new KMime::Content;
+    part->contentTransferEncoding()->setEncoding(KMime::Headers::CEbase64);
+    part->setBody(attachment);   //TODO: check it!
+    msg->addContent(part);
 
-    if (!from.isEmpty()) {
-        msg->from()->fromUnicodeString(from, "utf-8");
+    KMail::makeComposer(msg, false, false);
+    return true;
+}
+
+QString MailServiceImpl::sendMessageHeadless(const QVariantMap &message)
+{
+    const QString to = message.value(QStringLiteral("to")).toString();
+    const QString cc = message.value(QStringLiteral("cc")).toString();
+    const QString bcc = message.value(QStringLiteral("bcc")).toString();
+    if (to.isEmpty() && cc.isEmpty() && bcc.isEmpty()) {
+        return QStringLiteral("No recipient");
     }
-    if (!to.isEmpty()) {
-        msg->to()->fromUnicodeString(to, "utf-8");
+
+    const KIdentityManagement::IdentityManager *identityManager = KMKernel::self()->identityManager();
+    const KIdentityManagement::Identity &identity
+        = identityManager->identityForUoidOrDefault(message.value(QStringLiteral("identity"), 0).toUInt());
+
+    int transportId = message.value(QStringLiteral("transport"), -1).toInt();
+    if (transportId == -1 && !identity.transport().isEmpty()) {
+        transportId = identity.transport().toInt();
     }
-    if (!cc.isEmpty()) {
-        msg->cc()->fromUnicodeString(cc, "utf-8");
+    if (!MailTransport::TransportManager::self()->transportById(transportId, false)) {
+        transportId = MailTransport::TransportManager::self()->defaultTransportId();
     }
-    if (!bcc.isEmpty()) {
-        msg->bcc()->fromUnicodeString(bcc, "utf-8");
+    if (transportId == -1) {
+        return QStringLiteral("No mail transport configured");
     }
-    if (!subject.isEmpty()) {
-        msg->subject()->fromUnicodeString(subject, "utf-8");
+
+    KMime::Message::Ptr msg(new KMime::Message);
+    MessageHelper::initHeader(msg, identityManager, identity.uoid());
+    fillHeaders(msg, message.value(QStringLiteral("from")).toString(), to, cc, bcc, message.value(QStringLiteral("subject")).toString());
+    setKMailHeader(msg, "X-KMail-Identity", QString::number(identity.uoid()));
+    setKMailHeader(msg, "X-KMail-Transport", QString::number(transportId));
+    if (!identity.fcc().isEmpty()) {
+        setKMailHeader(msg, "X-KMail-Fcc", identity.fcc());
     }
-    if (!body.isEmpty()) {
-        msg->setBody(body.toUtf8());
+
+    const QByteArray body = message.value(QStringLiteral("body")).toString().toUtf8();
+    const QStringList attachments = message.value(QStringLiteral("attachments")).toStringList();
+    if (attachments.isEmpty()) {
+        msg->contentType()->setMimeType("text/plain");
+        msg->contentTransferEncoding()->setEncoding(KMime::Headers::CEquPr);
+        msg->setBody(body);
+    } else {
+        msg->contentType()->setMimeType("multipart/mixed");
+        msg->contentType()->setBoundary(KMime::multiPartBoundary());
+
+        auto textPart = new KMime::Content;
+        textPart->contentType()->setMimeType("text/plain");
+        textPart->contentType()->setCharset("utf-8");
+        textPart->contentTransferEncoding()->setEncoding(KMime::Headers::CEquPr);
+        textPart->setBody(body);
+        msg->addContent(textPart);
+
+        QMimeDatabase mimeDb;
+        for (const QString &fileName : attachments) {
+            QFile file(fileName);
+            if (!file.open(QIODevice::ReadOnly)) {
+                return QStringLiteral("Unable to read attachment %1").arg(fileName);
+            }
+            const QString name = QFileInfo(fileName).fileName();
+            auto part = new KMime::Content;
+            part->contentType()->setMimeType(mimeDb.mimeTypeForFile(fileName).name().toLatin1());
+            part->contentType()->setName(name, "utf-8");
+            part->contentDisposition()->setDisposition(KMime::Headers::CDattachment);
+            part->contentDisposition()->setFilename(name);
+            part->contentTransferEncoding()->setEncoding(KMime::Headers::CEbase64);
+            part->setBody(file.readAll());
+            msg->addContent(part);
+        }
     }
+    msg->assemble();
 
-    KMime::Content *part = new KMime::Content;
-    part->contentTransferEncoding()->setEncoding(KMime::Headers::CEbase64);
-    part->setBody(attachment);   //TODO: check it!
-    msg->addContent(part);
+    if (!KMKernel::self()->msgSender()->send(msg, MessageComposer::MessageSender::SendDefault)) {
+        return QStringLiteral("Unable to queue the message");
+    }
+    return QString();
+}
 
-    KMail::makeComposer(msg, false, false);
-    return true;
+QStringList MailServiceImpl::sendMessages(const QVariantList &messages)
+{
+    QStringList results;
+    results.reserve(messages.count());
+    for (const QVariant &message : messages) {
+        //Maps arrive wrapped in a QDBusArgument when called over D-Bus
+        const QVariantMap map = message.canConvert<QDBusArgument>()
+                                ? qdbus_cast<QVariantMap>(message.value<QDBusArgument>())
+                                : message.toMap();
+        results.append(sendMessageHeadless(map));
+    }
+    qCDebug(KMAIL_LOG) << "Sent" << messages.count() << "messages over D-Bus," << results.count(QString()) << "queued";
+    return results;
 }
@@ -33,20 +33,36 @@
 class QByteArray;
 class QString;
 #include <QObject>
+#include <QStringList>
+#include <QVariantList>
 
 namespace KMail {
 // This class implements the D-Bus interface
 // libkdepim/interfaces/org.kde.mailtransport.service.xml
+// and the headless org.kde.kmail.MailService interface from its scriptable slots.
 class MailServiceImpl : public QObject
 {
     Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kmail.MailService")
 public:
     MailServiceImpl();
     Q_REQUIRED_RESULT bool sendMessage(const QString &from, const QString &to, const QString &cc, const QString &bcc, const QString &subject, const QString &body, const QStringList &attachments);
 
     Q_REQUIRED_RESULT bool sendMessage(const QString &from, const QString &to, const QString &cc, const QString &bcc, const QString &subject, const QString &body, const QByteArray &attachment);
+
+public Q_SLOTS:
+    /**
+     * Sends @p messages without opening any composer. Each entry is a map with
+     * the keys "from", "to", "cc", "bcc", "subject", "body", "attachments" (a
+     * list of local files), "identity" (identity uoid) and "transport" (transport id).
+     * Identity, transport and sent-mail folder default to the identity settings.
+     * @return one entry per message: empty if it was queued, else the error.
+     */
+    Q_SCRIPTABLE QStringList sendMessages(const QVariantList &messages);
+
 private:
     Q_DISABLE_COPY(MailServiceImpl)
+    Q_REQUIRED_RESULT QString sendMessageHeadless(const QVariantMap &message);
 };
 }
 
@@ -0,0 +1,229 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "maintenancescheduler.h"
+#include "kmail_debug.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QThread>
+#include <QTimer>
+
+#ifdef Q_OS_UNIX
+#include <stdlib.h>
+#endif
+
+using namespace KMail;
+
+static const int s_defaultIdleTimeout = 5 * 60 * 1000;
+static const int s_defaultCheckInterval = 60 * 1000;
+
+static KConfigGroup lastRunGroup()
+{
+    const KSharedConfig::Ptr cfg = KSharedConfig::openConfig(QStringLiteral("kmailmaintenancerc"));
+    return cfg->group(QStringLiteral("LastRun"));
+}
+
+MaintenanceScheduler::MaintenanceScheduler(QObject *parent)
+    : QObject(parent)
+    , mIdleTimeout(s_defaultIdleTimeout)
+    , mCheckInterval(s_defaultCheckInterval)
+{
+    mTimer = new QTimer(this);
+    mTimer->setSingleShot(true);
+    connect(mTimer, &QTimer::timeout, this, &MaintenanceScheduler::checkTasks);
+    mLastUserActivity.start();
+    qApp->installEventFilter(this);
+}
+
+MaintenanceScheduler::~MaintenanceScheduler()
+{
+}
+
+void MaintenanceScheduler::addTask(const Task &task)
+{
+    mTasks.append(task);
+    const QDateTime lastRun = lastRunGroup().readEntry(task.name, QDateTime());
+    if (lastRun.isValid()) {
+        mLastRun.insert(task.name, lastRun);
+    }
+}
+
+void MaintenanceScheduler::taskFinished(const QString &name)
+{
+    if (mRunningTask < 0 || mTasks.at(mRunningTask).name != name) {
+        return;
+    }
+    qCDebug(KMAIL_LOG) << "Maintenance task finished:" << name;
+    mRunningTask = -1;
+    mPreempted = false;
+    saveLastRun(name);
+}
+
+void MaintenanceScheduler::start(int delay)
+{
+    mTimer->start(delay);
+}
+
+void MaintenanceScheduler::pause()
+{
+    mPaused = true;
+    mTimer->stop();
+    preemptRunningTask();
+}
+
+void MaintenanceScheduler::resume()
+{
+    mPaused = false;
+    mTimer->start(mCheckInterval);
+}
+
+void MaintenanceScheduler::setIdleTimeout(int msecs)
+{
+    mIdleTimeout = msecs;
+}
+
+void MaintenanceScheduler::setCheckInterval(int msecs)
+{
+    mCheckInterval = msecs;
+}
+
+QString MaintenanceScheduler::runningTask() const
+{
+    return mRunningTask < 0 ? QString() : mTasks.at(mRunningTask).name;
+}
+
+QDateTime MaintenanceScheduler::lastRun(const QString &name) const
+{
+    return mLastRun.value(name);
+}
+
+bool MaintenanceScheduler::eventFilter(QObject *obj, QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+        mLastUserActivity.restart();
+        //The user is back, don't compete with them
+        preemptRunningTask();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(obj, event);
+}
+
+void MaintenanceScheduler::preemptRunningTask()
+{
+    if (mRunningTask < 0 || mPreempted) {
+        return;
+    }
+    const Task &task = mTasks.at(mRunningTask);
+    qCDebug(KMAIL_LOG) << "Pausing maintenance task:" << task.name;
+    mPreempted = true;
+    if (task.pause) {
+        task.pause();
+    }
+}
+
+bool MaintenanceScheduler::userIsIdle() const
+{
+    return mLastUserActivity.hasExpired(mIdleTimeout);
+}
+
+bool MaintenanceScheduler::systemIsLoaded() const
+{
+#ifdef Q_OS_UNIX
+    double load = 0.0;
+    if (getloadavg(&load, 1) == 1 && load > QThread::idealThreadCount()) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+int MaintenanceScheduler::nextDueTask() const
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    const bool loaded = systemIsLoaded();
+    int next = -1;
+    QDateTime nextDueTime;
+    for (int i = 0, total = mTasks.count(); i < total; ++i) {
+        const Task &task = mTasks.at(i);
+        if (task.cost == HeavyTask && loaded) {
+            continue;
+        }
+        const QDateTime lastRun = mLastRun.value(task.name);
+        //Never run tasks come first
+        const QDateTime dueTime = lastRun.isValid() ? lastRun.addSecs(task.interval) : QDateTime::fromMSecsSinceEpoch(0);
+        if (dueTime <= now && (next < 0 || dueTime < nextDueTime)) {
+            next = i;
+            nextDueTime = dueTime;
+        }
+    }
+    return next;
+}
+
+void MaintenanceScheduler::checkTasks()
+{
+    if (mPaused) {
+        return;
+    }
+    if (userIsIdle()) {
+        if (mRunningTask >= 0) {
+            if (mPreempted) {
+                const Task &task = mTasks.at(mRunningTask);
+                qCDebug(KMAIL_LOG) << "Resuming maintenance task:" << task.name;
+                mPreempted = false;
+                if (task.resume) {
+                    task.resume();
+                }
+            }
+        } else {
+            //Tasks with nothing to do are done at once, go on with the next one
+            int next = nextDueTask();
+            while (next >= 0) {
+                const Task &task = mTasks.at(next);
+                qCDebug(KMAIL_LOG) << "Starting maintenance task:" << task.name;
+                mRunningTask = next;
+                Q_EMIT taskStarted(task.name);
+                if (task.start && task.start()) {
+                    break;
+                }
+                mRunningTask = -1;
+                saveLastRun(task.name);
+                next = nextDueTask();
+            }
+        }
+    }
+    mTimer->start(mCheckInterval);
+}
+
+void MaintenanceScheduler::saveLastRun(const QString &name)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    mLastRun.insert(name, now);
+    KConfigGroup grp = lastRunGroup();
+    grp.writeEntry(name, now);
+    grp.sync();
+}
@@ -0,0 +1,115 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef MAINTENANCESCHEDULER_H
+#define MAINTENANCESCHEDULER_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QVector>
+#include <functional>
+
+class QTimer;
+
+namespace KMail {
+/**
+ * Runs the periodic maintenance tasks (expiry, index checks...) one after the
+ * other, only while the user is not working in KMail. Heavy tasks also wait
+ * until the system is not loaded. A running task is paused as soon as the user
+ * comes back and resumed once they are idle again. The time of the last run of
+ * each task is kept across restarts, so a task isn't run again on each start.
+ */
+class MaintenanceScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum TaskCost {
+        LightTask,
+        HeavyTask
+    };
+
+    struct Task {
+        QString name;
+        TaskCost cost = LightTask;
+        /// Seconds between two runs
+        int interval = 0;
+        /// Starts the task, returns false when there was nothing to do.
+        std::function<bool()> start;
+        std::function<void()> pause;
+        std::function<void()> resume;
+    };
+
+    explicit MaintenanceScheduler(QObject *parent = nullptr);
+    ~MaintenanceScheduler() override;
+
+    void addTask(const Task &task);
+
+    /**
+     * Must be called by the task started by the scheduler when it is done.
+     * It is ignored for a task which isn't running.
+     */
+    void taskFinished(const QString &name);
+
+    /**
+     * Starts checking for due tasks, the first time after @p delay ms.
+     */
+    void start(int delay);
+
+    /**
+     * Pauses the running task and doesn't start new ones until resume().
+     */
+    void pause();
+    void resume();
+
+    void setIdleTimeout(int msecs);
+    void setCheckInterval(int msecs);
+
+    Q_REQUIRED_RESULT QString runningTask() const;
+    Q_REQUIRED_RESULT QDateTime lastRun(const QString &name) const;
+
+Q_SIGNALS:
+    void taskStarted(const QString &name);
+
+protected:
+    bool eventFilter(QObject *obj, QEvent *event) override;
+
+private:
+    Q_DISABLE_COPY(MaintenanceScheduler)
+    void checkTasks();
+    void preemptRunningTask();
+    Q_REQUIRED_RESULT int nextDueTask() const;
+    Q_REQUIRED_RESULT bool userIsIdle() const;
+    Q_REQUIRED_RESULT bool systemIsLoaded() const;
+    void saveLastRun(const QString &name);
+
+    QVector<Task> mTasks;
+    QHash<QString, QDateTime> mLastRun;
+    QElapsedTimer mLastUserActivity;
+    QTimer *mTimer = nullptr;
+    int mRunningTask = -1;
+    int mIdleTimeout;
+    int mCheckInterval;
+    bool mPreempted = false;
+    bool mPaused = false;
+};
+}
+
+#endif // MAINTENANCESCHEDULER_H
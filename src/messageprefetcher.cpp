@@ -0,0 +1,138 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "messageprefetcher.h"
+#include "kmail_debug.h"
+
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <KMime/Message>
+
+#include <algorithm>
+
+using namespace KMail;
+
+static const int s_prefetchCount = 3;
+static const int s_maximumCacheSizeKiB = 50 * 1024;
+
+static int cacheCost(const Akonadi::Item &item)
+{
+    return qMax<qint64>(1, item.size() / 1024);
+}
+
+MessagePrefetcher::MessagePrefetcher(QObject *parent)
+    : QObject(parent)
+    , mCache(s_maximumCacheSizeKiB)
+{
+}
+
+MessagePrefetcher::~MessagePrefetcher()
+{
+    for (auto it = mPrefetchJobs.cbegin(), end = mPrefetchJobs.cend(); it != end; ++it) {
+        it.key()->kill(KJob::Quietly);
+    }
+}
+
+Akonadi::Item MessagePrefetcher::cachedItem(const Akonadi::Item &item) const
+{
+    //Flag changes (e.g. marking as read) bump the revision but leave the
+    //message alone, only a different size means its content was replaced
+    const Akonadi::Item *cached = mCache.object(item.id());
+    if (!cached || !cached->hasPayload<KMime::Message::Ptr>()
+        || (item.size() > 0 && cached->size() != item.size())) {
+        return Akonadi::Item();
+    }
+    Akonadi::Item result(*cached);
+    result.setFlags(item.flags());
+    result.setRevision(item.revision());
+    return result;
+}
+
+void MessagePrefetcher::insert(const Akonadi::Item &item)
+{
+    if (!item.isValid() || !item.hasPayload<KMime::Message::Ptr>()) {
+        return;
+    }
+    mCache.insert(item.id(), new Akonadi::Item(item), cacheCost(item));
+}
+
+void MessagePrefetcher::clear()
+{
+    mCache.clear();
+}
+
+int MessagePrefetcher::prefetchDistance()
+{
+    return s_prefetchCount;
+}
+
+void MessagePrefetcher::prefetch(const Akonadi::Item::List &items)
+{
+    QSet<Akonadi::Item::Id> wanted;
+    Akonadi::Item::List toFetch;
+    for (const Akonadi::Item &item : items) {
+        if (!item.isValid() || cachedItem(item).isValid()) {
+            continue;
+        }
+        wanted.insert(item.id());
+        toFetch.append(item);
+    }
+
+    //The user jumped away: drop prefetches which are of no use anymore
+    for (auto it = mPrefetchJobs.begin(); it != mPrefetchJobs.end();) {
+        if (!it.value().intersects(wanted)) {
+            it.key()->kill(KJob::Quietly);
+            it = mPrefetchJobs.erase(it);
+        } else {
+            for (Akonadi::Item::Id id : it.value()) {
+                wanted.remove(id);
+            }
+            ++it;
+        }
+    }
+    toFetch.erase(std::remove_if(toFetch.begin(), toFetch.end(), [&wanted](const Akonadi::Item &item) {
+        return !wanted.contains(item.id());
+    }), toFetch.end());
+    if (toFetch.isEmpty()) {
+        return;
+    }
+
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(toFetch, this);
+    job->fetchScope().fetchFullPayload();
+    job->fetchScope().fetchAllAttributes();
+    job->fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &MessagePrefetcher::slotItemsReceived);
+    connect(job, &KJob::result, this, &MessagePrefetcher::slotPrefetchDone);
+    mPrefetchJobs.insert(job, wanted);
+}
+
+void MessagePrefetcher::slotItemsReceived(const Akonadi::Item::List &items)
+{
+    for (const Akonadi::Item &item : items) {
+        insert(item);
+    }
+}
+
+void MessagePrefetcher::slotPrefetchDone(KJob *job)
+{
+    mPrefetchJobs.remove(job);
+    if (job->error()) {
+        qCDebug(KMAIL_LOG) << "Prefetching messages failed:" << job->errorString();
+    }
+}
@@ -0,0 +1,74 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef MESSAGEPREFETCHER_H
+#define MESSAGEPREFETCHER_H
+
+#include <QCache>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <AkonadiCore/Item>
+
+class KJob;
+
+namespace KMail {
+/**
+ * Keeps the last displayed and prefetched messages, parsed, so that switching
+ * between messages doesn't wait for the resource. The cache is bounded by the
+ * size of the messages and shared by the preview pane and the reader windows.
+ */
+class MessagePrefetcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MessagePrefetcher(QObject *parent = nullptr);
+    ~MessagePrefetcher() override;
+
+    /**
+     * Returns the cached message for @p item, with the flags of @p item, or an
+     * invalid item if it is not cached or its content was replaced since.
+     */
+    Q_REQUIRED_RESULT Akonadi::Item cachedItem(const Akonadi::Item &item) const;
+    void insert(const Akonadi::Item &item);
+    void clear();
+
+    /**
+     * Fetches @p items, the messages shown around the current one, nearest
+     * first. Running prefetches of other messages are canceled.
+     */
+    void prefetch(const Akonadi::Item::List &items);
+
+    /**
+     * Returns how many messages before and after the current one are worth
+     * prefetching.
+     */
+    Q_REQUIRED_RESULT static int prefetchDistance();
+
+private:
+    Q_DISABLE_COPY(MessagePrefetcher)
+    void slotItemsReceived(const Akonadi::Item::List &items);
+    void slotPrefetchDone(KJob *job);
+
+    QCache<Akonadi::Item::Id, Akonadi::Item> mCache;
+    QHash<KJob *, QSet<Akonadi::Item::Id> > mPrefetchJobs;
+};
+}
+
+#endif // MESSAGEPREFETCHER_H
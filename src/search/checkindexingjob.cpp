@@ -37,27 +37,27 @@ CheckIndexingJob::~CheckIndexingJob()
 {
 }
 
-void CheckIndexingJob::askForNextCheck(quint64 id, bool needToReindex)
+void CheckIndexingJob::askForNextCheck(const QVector<Akonadi::Collection::Id> &checkedCollections, const QVector<Akonadi::Collection::Id> &collectionsToReindex)
 {
-    Q_EMIT finished(id, needToReindex);
+    Q_EMIT finished(checkedCollections, collectionsToReindex);
     deleteLater();
 }
 
-void CheckIndexingJob::setCollection(const Akonadi::Collection &col)
+void CheckIndexingJob::setCollections(const Akonadi::Collection::List &cols)
 {
-    mCollection = col;
+    mCollections = cols;
 }
 
 void CheckIndexingJob::start()
 {
-    if (mCollection.isValid()) {
-        Akonadi::CollectionFetchJob *fetch = new Akonadi::CollectionFetchJob(mCollection,
+    if (!mCollections.isEmpty()) {
+        Akonadi::CollectionFetchJob *fetch = new Akonadi::CollectionFetchJob(mCollections,
                                                                              Akonadi::CollectionFetchJob::Base);
         fetch->fetchScope().setIncludeStatistics(true);
         connect(fetch, &KJob::result, this, &CheckIndexingJob::slotCollectionPropertiesFinished);
     } else {
-        qCWarning(KMAIL_LOG) << "Collection was not valid";
-        askForNextCheck(-1);
+        qCWarning(KMAIL_LOG) << "No collection to check";
+        askForNextCheck();
     }
 }
 
@@ -65,19 +65,25 @@ void CheckIndexingJob::slotCollectionPropertiesFinished(KJob *job)
 {
     Akonadi::CollectionFetchJob *fetch = qobject_cast<Akonadi::CollectionFetchJob *>(job);
     Q_ASSERT(fetch);
-    if (fetch->collections().isEmpty()) {
-        qCWarning(KMAIL_LOG) << "No collection fetched";
-        askForNextCheck(-1);
+    if (job->error()) {
+        //None of them was checked, they are tried again by the next pass
+        qCWarning(KMAIL_LOG) << "Unable to fetch collections statistics" << job->errorString();
+        askForNextCheck();
         return;
     }
 
-    mCollection = fetch->collections().constFirst();
-    const qlonglong result = mIndexedItems->indexedItems(mCollection.id());
-    bool needToReindex = false;
-    qCDebug(KMAIL_LOG) << "name :" << mCollection.name() << " mCollection.statistics().count() " << mCollection.statistics().count() << "stats.value(mCollection.id())" << result;
-    if (mCollection.statistics().count() != result) {
-        needToReindex = true;
-        qCDebug(KMAIL_LOG) << "Reindex collection :" << "name :" << mCollection.name();
+    QVector<Akonadi::Collection::Id> checkedCollections;
+    QVector<Akonadi::Collection::Id> collectionsToReindex;
+    const Akonadi::Collection::List cols = fetch->collections();
+    checkedCollections.reserve(cols.count());
+    for (const Akonadi::Collection &col : cols) {
+        checkedCollections.append(col.id());
+        const qlonglong result = mIndexedItems->indexedItems(col.id());
+        qCDebug(KMAIL_LOG) << "name :" << col.name() << " col.statistics().count() " << col.statistics().count() << "stats.value(col.id())" << result;
+        if (col.statistics().count() != result) {
+            collectionsToReindex.append(col.id());
+            qCDebug(KMAIL_LOG) << "Reindex collection :" << "name :" << col.name();
+        }
     }
-    askForNextCheck(mCollection.id(), needToReindex);
+    askForNextCheck(checkedCollections, collectionsToReindex);
 }
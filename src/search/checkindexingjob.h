@@ -21,6 +21,7 @@
 #define CHECKINDEXINGJOB_H
 
 #include <QObject>
+#include <QVector>
 #include <AkonadiCore/Collection>
 namespace Akonadi {
 namespace Search {
@@ -30,6 +31,10 @@ class IndexedItems;
 }
 }
 class KJob;
+/**
+ * Compares the item count of a batch of collections, fetched together with
+ * their statistics, with the number of items the indexer knows about.
+ */
 class CheckIndexingJob : public QObject
 {
     Q_OBJECT
@@ -37,18 +42,19 @@ public:
     explicit CheckIndexingJob(Akonadi::Search::PIM::IndexedItems *indexedItems, QObject *parent = nullptr);
     ~CheckIndexingJob();
 
-    void setCollection(const Akonadi::Collection &col);
+    void setCollections(const Akonadi::Collection::List &cols);
 
     void start();
 
 Q_SIGNALS:
-    void finished(Akonadi::Collection::Id id, bool needToReindex);
+    void finished(const QVector<Akonadi::Collection::Id> &checkedCollections, const QVector<Akonadi::Collection::Id> &collectionsToReindex);
 
 private:
     Q_DISABLE_COPY(CheckIndexingJob)
     void slotCollectionPropertiesFinished(KJob *job);
-    void askForNextCheck(quint64 id, bool needToReindex = false);
-    Akonadi::Collection mCollection;
+    void askForNextCheck(const QVector<Akonadi::Collection::Id> &checkedCollections = QVector<Akonadi::Collection::Id>(),
+                         const QVector<Akonadi::Collection::Id> &collectionsToReindex = QVector<Akonadi::Collection::Id>());
+    Akonadi::Collection::List mCollections;
     Akonadi::Search::PIM::IndexedItems *mIndexedItems = nullptr;
 };
 
@@ -29,27 +29,83 @@
 #include <PimCommon/PimUtil>
 #include <PimCommonAkonadi/MailUtil>
 #include <AkonadiSearch/PIM/indexeditems.h>
+#include <QGuiApplication>
+#include <QThread>
 #include <QTimer>
 #include <QDBusInterface>
 #include <QDBusPendingCall>
 #include <AkonadiCore/entityhiddenattribute.h>
 
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <stdlib.h>
+#endif
+
+static const int s_collectionsPerBatch = 100;
+static const int s_checkInterval = 5 * 1000;
+static const int s_busyRetryInterval = 60 * 1000;
+
 CheckIndexingManager::CheckIndexingManager(Akonadi::Search::PIM::IndexedItems *indexer, QObject *parent)
     : QObject(parent)
     , mIndexedItems(indexer)
 {
     mTimer = new QTimer(this);
     mTimer->setSingleShot(true);
-    mTimer->setInterval(5 * 1000); //5 secondes
     connect(mTimer, &QTimer::timeout, this, &CheckIndexingManager::checkNextCollection);
 }
 
 CheckIndexingManager::~CheckIndexingManager()
 {
     callToReindexCollection();
+    saveProgress();
+}
+
+void CheckIndexingManager::saveProgress()
+{
     const KSharedConfig::Ptr cfg = KSharedConfig::openConfig(QStringLiteral("kmailsearchindexingrc"));
     KConfigGroup grp = cfg->group(QStringLiteral("General"));
     grp.writeEntry(QStringLiteral("collectionsIndexed"), mCollectionsIndexed);
+    grp.sync();
+}
+
+void CheckIndexingManager::collectionStatisticsChanged(Akonadi::Collection::Id id)
+{
+    ++mChangeActivity[id];
+}
+
+bool CheckIndexingManager::isBusy() const
+{
+    //Don't compete with the user for the disk and the indexer
+    if (qApp->applicationState() == Qt::ApplicationActive) {
+        return true;
+    }
+#ifdef Q_OS_UNIX
+    double load = 0.0;
+    if (getloadavg(&load, 1) == 1 && load > QThread::idealThreadCount()) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+void CheckIndexingManager::pause()
+{
+    mPaused = true;
+    mTimer->stop();
+}
+
+void CheckIndexingManager::resume()
+{
+    mPaused = false;
+    if (!mIsReady && !mJobRunning) {
+        mTimer->start(s_checkInterval);
+    }
+}
+
+bool CheckIndexingManager::isRunning() const
+{
+    return !mIsReady;
 }
 
 void CheckIndexingManager::start(QAbstractItemModel *collectionModel)
@@ -64,12 +120,24 @@ void CheckIndexingManager::start(QAbstractItemModel *collectionModel)
             mIndex = 0;
             mListCollection.clear();
             mCollectionsIndexed = grp.readEntry(QStringLiteral("collectionsIndexed"), QList<qint64>());
+            mCollectionsIndexedSet.clear();
+            for (qint64 id : qAsConst(mCollectionsIndexed)) {
+                mCollectionsIndexedSet.insert(id);
+            }
+            mCheckFailed = false;
             if (collectionModel) {
                 initializeCollectionList(collectionModel);
+                //Check the folders which changed the most first
+                std::stable_sort(mListCollection.begin(), mListCollection.end(),
+                                 [this](const Akonadi::Collection &lhs, const Akonadi::Collection &rhs) {
+                    return mChangeActivity.value(lhs.id()) > mChangeActivity.value(rhs.id());
+                });
                 if (!mListCollection.isEmpty()) {
                     qCDebug(KMAIL_LOG) << "Number of collection to check " << mListCollection.count();
                     mIsReady = false;
-                    mTimer->start();
+                    if (!mPaused) {
+                        mTimer->start(s_checkInterval);
+                    }
                 }
             }
         }
@@ -79,14 +147,21 @@ void CheckIndexingManager::start(QAbstractItemModel *collectionModel)
 void CheckIndexingManager::createJob()
 {
     CheckIndexingJob *job = new CheckIndexingJob(mIndexedItems, this);
-    job->setCollection(mListCollection.at(mIndex));
+    const Akonadi::Collection::List batch = mListCollection.mid(mIndex, s_collectionsPerBatch);
+    mBatchCount = batch.count();
+    job->setCollections(batch);
     connect(job, &CheckIndexingJob::finished, this, &CheckIndexingManager::indexingFinished);
+    mJobRunning = true;
     job->start();
 }
 
 void CheckIndexingManager::checkNextCollection()
 {
     if (mIndex < mListCollection.count()) {
+        if (isBusy()) {
+            mTimer->start(s_busyRetryInterval);
+            return;
+        }
         createJob();
     }
 }
@@ -103,37 +178,53 @@ void CheckIndexingManager::callToReindexCollection()
     }
 }
 
-void CheckIndexingManager::indexingFinished(qint64 index, bool reindexCollection)
+void CheckIndexingManager::indexingFinished(const QVector<Akonadi::Collection::Id> &checkedCollections, const QVector<Akonadi::Collection::Id> &collectionsToReindex)
 {
-    if (index != -1) {
-        if (!mCollectionsIndexed.contains(index)) {
-            mCollectionsIndexed.append(index);
-        }
+    mJobRunning = false;
+    if (checkedCollections.count() < mBatchCount) {
+        mCheckFailed = true;
     }
-    if (reindexCollection) {
-        if (!mCollectionsNeedToBeReIndexed.contains(index)) {
-            mCollectionsNeedToBeReIndexed.append(index);
+    for (Akonadi::Collection::Id id : checkedCollections) {
+        if (!mCollectionsIndexedSet.contains(id)) {
+            mCollectionsIndexedSet.insert(id);
+            mCollectionsIndexed.append(id);
         }
-        if (mCollectionsNeedToBeReIndexed.count() > 30) {
-            callToReindexCollection();
-            mCollectionsNeedToBeReIndexed.clear();
+        mChangeActivity.remove(id);
+    }
+    for (Akonadi::Collection::Id id : collectionsToReindex) {
+        if (!mCollectionsNeedToBeReIndexedSet.contains(id)) {
+            mCollectionsNeedToBeReIndexedSet.insert(id);
+            mCollectionsNeedToBeReIndexed.append(id);
         }
     }
-    mIndex++;
+    //Don't lose the collections which need to be reindexed if we stop before the end
+    callToReindexCollection();
+    mCollectionsNeedToBeReIndexed.clear();
+    mCollectionsNeedToBeReIndexedSet.clear();
+    mIndex += s_collectionsPerBatch;
     if (mIndex < mListCollection.count()) {
-        mTimer->start();
+        saveProgress();
+        if (!mPaused) {
+            mTimer->start(s_checkInterval);
+        }
     } else {
         mIsReady = true;
         mIndex = 0;
-        callToReindexCollection();
         mListCollection.clear();
-        mCollectionsNeedToBeReIndexed.clear();
 
-        const KSharedConfig::Ptr cfg = KSharedConfig::openConfig(QStringLiteral("kmailsearchindexingrc"));
-        KConfigGroup grp = cfg->group(QStringLiteral("General"));
-        grp.writeEntry(QStringLiteral("lastCheck"), QDateTime::currentDateTime());
-        grp.deleteEntry(QStringLiteral("collectionsIndexed"));
-        grp.sync();
+        if (mCheckFailed) {
+            //Keep what was checked, the next pass only checks the collections which failed
+            saveProgress();
+        } else {
+            const KSharedConfig::Ptr cfg = KSharedConfig::openConfig(QStringLiteral("kmailsearchindexingrc"));
+            KConfigGroup grp = cfg->group(QStringLiteral("General"));
+            grp.writeEntry(QStringLiteral("lastCheck"), QDateTime::currentDateTime());
+            grp.deleteEntry(QStringLiteral("collectionsIndexed"));
+            grp.sync();
+            mCollectionsIndexed.clear();
+            mCollectionsIndexedSet.clear();
+        }
+        Q_EMIT finished();
     }
 }
 
@@ -155,7 +246,7 @@ void CheckIndexingManager::initializeCollectionList(QAbstractItemModel *model, c
         if (PimCommon::Util::isImapResource(collection.resource()) && !collection.cachePolicy().localParts().contains(QLatin1String("RFC822"))) {
             continue;
         }
-        if (!mCollectionsIndexed.contains(collection.id())) {
+        if (!mCollectionsIndexedSet.contains(collection.id())) {
             mListCollection.append(collection);
         }
         if (model->rowCount(index) > 0) {
@@ -23,6 +23,9 @@
 #include <QObject>
 #include <AkonadiCore/Collection>
 #include <QAbstractItemModel>
+#include <QHash>
+#include <QSet>
+#include <QVector>
 namespace Akonadi {
 namespace Search {
 namespace PIM {
@@ -31,6 +34,12 @@ class IndexedItems;
 }
 }
 class QTimer;
+/**
+ * Checks once a week that all local collections are fully indexed. Collections
+ * are checked in batches, most recently changed first, only while KMail is in
+ * the background and the system is not loaded. Progress is saved after each
+ * batch so that an interrupted pass resumes where it stopped.
+ */
 class CheckIndexingManager : public QObject
 {
     Q_OBJECT
@@ -40,11 +49,23 @@ public:
 
     void start(QAbstractItemModel *collectionModel);
 
+    void collectionStatisticsChanged(Akonadi::Collection::Id id);
+
+    void pause();
+    void resume();
+
+    Q_REQUIRED_RESULT bool isRunning() const;
+
+Q_SIGNALS:
+    void finished();
+
 private:
     Q_DISABLE_COPY(CheckIndexingManager)
     void checkNextCollection();
+    Q_REQUIRED_RESULT bool isBusy() const;
+    void saveProgress();
 
-    void indexingFinished(qint64 index, bool reindexCollection);
+    void indexingFinished(const QVector<Akonadi::Collection::Id> &checkedCollections, const QVector<Akonadi::Collection::Id> &collectionsToReindex);
 
     void initializeCollectionList(QAbstractItemModel *model, const QModelIndex &parentIndex = QModelIndex());
     void createJob();
@@ -53,10 +74,18 @@ private:
     Akonadi::Search::PIM::IndexedItems *mIndexedItems = nullptr;
     Akonadi::Collection::List mListCollection;
     QTimer *mTimer = nullptr;
+    //The lists are saved and sent to the indexer, the sets are for lookups
     QList<qint64> mCollectionsIndexed;
+    QSet<qint64> mCollectionsIndexedSet;
     QList<qint64> mCollectionsNeedToBeReIndexed;
+    QSet<qint64> mCollectionsNeedToBeReIndexedSet;
+    QHash<Akonadi::Collection::Id, int> mChangeActivity;
     int mIndex = 0;
+    int mBatchCount = 0;
     bool mIsReady = true;
+    bool mCheckFailed = false;
+    bool mPaused = false;
+    bool mJobRunning = false;
 };
 
 #endif // CHECKINDEXINGMANAGER_H
@@ -0,0 +1,101 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "incompleteindexchecker.h"
+#include "kmkernel.h"
+#include "kmail_debug.h"
+
+#include <AkonadiCore/Monitor>
+#include <AkonadiSearch/PIM/indexeditems.h>
+
+#include <QHash>
+#include <QTimer>
+
+static const int s_collectionsPerBatch = 25;
+
+//Statistics count of the collections which were fully indexed when last checked
+typedef QHash<Akonadi::Collection::Id, qint64> IndexedCountCache;
+Q_GLOBAL_STATIC(IndexedCountCache, s_indexedCountCache)
+
+IncompleteIndexChecker::IncompleteIndexChecker(QObject *parent)
+    : QObject(parent)
+{
+    mBatchTimer = new QTimer(this);
+    mBatchTimer->setSingleShot(true);
+    mBatchTimer->setInterval(0);
+    connect(mBatchTimer, &QTimer::timeout, this, &IncompleteIndexChecker::checkNextBatch);
+    connect(KMKernel::self()->folderCollectionMonitor(), &Akonadi::Monitor::collectionStatisticsChanged,
+            this, &IncompleteIndexChecker::slotCollectionStatisticsChanged);
+}
+
+IncompleteIndexChecker::~IncompleteIndexChecker() = default;
+
+void IncompleteIndexChecker::start(const Akonadi::Collection::List &collections)
+{
+    mCollections = collections;
+    mUnindexedCollections.clear();
+    mCurrentIndex = 0;
+    mBatchTimer->start();
+}
+
+void IncompleteIndexChecker::stop()
+{
+    mBatchTimer->stop();
+    mCollections.clear();
+    mCurrentIndex = 0;
+}
+
+bool IncompleteIndexChecker::isRunning() const
+{
+    return mBatchTimer->isActive();
+}
+
+void IncompleteIndexChecker::slotCollectionStatisticsChanged(Akonadi::Collection::Id id)
+{
+    s_indexedCountCache->remove(id);
+}
+
+void IncompleteIndexChecker::checkNextBatch()
+{
+    Akonadi::Search::PIM::IndexedItems *indexedItems = KMKernel::self()->indexedItems();
+    const int end = qMin(mCurrentIndex + s_collectionsPerBatch, mCollections.count());
+    for (; mCurrentIndex < end; ++mCurrentIndex) {
+        const Akonadi::Collection &col = mCollections.at(mCurrentIndex);
+        const qint64 count = col.statistics().count();
+        const auto it = s_indexedCountCache->constFind(col.id());
+        if (it != s_indexedCountCache->constEnd() && it.value() == count) {
+            continue;
+        }
+        const qlonglong num = indexedItems->indexedItems(static_cast<qlonglong>(col.id()));
+        if (count != num) {
+            mUnindexedCollections.push_back(col.id());
+        } else {
+            s_indexedCountCache->insert(col.id(), count);
+        }
+    }
+
+    if (mCurrentIndex < mCollections.count()) {
+        mBatchTimer->start();
+        return;
+    }
+    qCDebug(KMAIL_LOG) << "Index checked for" << mCollections.count() << "collections," << mUnindexedCollections.count() << "incomplete";
+    mCollections.clear();
+    mCurrentIndex = 0;
+    Q_EMIT finished(mUnindexedCollections);
+}
@@ -0,0 +1,60 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef INCOMPLETEINDEXCHECKER_H
+#define INCOMPLETEINDEXCHECKER_H
+
+#include <QObject>
+#include <QVector>
+#include <AkonadiCore/Collection>
+
+class QTimer;
+
+/**
+ * Compares the number of indexed items with the collection statistics of the
+ * searched collections without blocking the search window. Collections are
+ * checked in batches from the event loop. Collections found fully indexed are
+ * remembered between searches until their statistics change.
+ */
+class IncompleteIndexChecker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IncompleteIndexChecker(QObject *parent = nullptr);
+    ~IncompleteIndexChecker() override;
+
+    void start(const Akonadi::Collection::List &collections);
+    void stop();
+    Q_REQUIRED_RESULT bool isRunning() const;
+
+Q_SIGNALS:
+    void finished(const QVector<qint64> &unindexedCollections);
+
+private:
+    Q_DISABLE_COPY(IncompleteIndexChecker)
+    void checkNextBatch();
+    void slotCollectionStatisticsChanged(Akonadi::Collection::Id id);
+
+    Akonadi::Collection::List mCollections;
+    QVector<qint64> mUnindexedCollections;
+    int mCurrentIndex = 0;
+    QTimer *mBatchTimer = nullptr;
+};
+
+#endif // INCOMPLETEINDEXCHECKER_H
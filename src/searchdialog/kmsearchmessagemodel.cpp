@@ -31,6 +31,7 @@
 
 #include <MessageCore/StringUtil>
 
+#include <AkonadiCore/itemfetchjob.h>
 #include <AkonadiCore/itemfetchscope.h>
 #include <AkonadiCore/monitor.h>
 #include <AkonadiCore/session.h>
@@ -41,21 +42,36 @@
 #include <QColor>
 #include <QApplication>
 #include <QPalette>
+#include <QTimer>
 #include "kmail_debug.h"
 #include <KLocalizedString>
 #include <KFormat>
 
+static const int s_maximumCachedMessages = 200;
+static const int s_fetchBatchSize = 50;
+
 KMSearchMessageModel::KMSearchMessageModel(Akonadi::Monitor *monitor, QObject *parent)
     : Akonadi::MessageModel(monitor, parent)
+    , m_fullItemCache(s_maximumCachedMessages)
 {
-    monitor->itemFetchScope().fetchFullPayload();
-    monitor->itemFetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::All);
+    //The columns only need the headers, the folder path is resolved from the
+    //collection model and cached per collection, so don't fetch ancestors either.
+    monitor->itemFetchScope().fetchPayloadPart(Akonadi::MessagePart::Envelope);
+    monitor->itemFetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::None);
+
+    m_fetchTimer = new QTimer(this);
+    m_fetchTimer->setSingleShot(true);
+    m_fetchTimer->setInterval(0);
+    connect(m_fetchTimer, &QTimer::timeout, this, &KMSearchMessageModel::slotFetchPendingItems);
 }
 
 KMSearchMessageModel::~KMSearchMessageModel() = default;
 
 static QString toolTip(const Akonadi::Item &item)
 {
+    if (!item.hasPayload<KMime::Message::Ptr>()) {
+        return QString();
+    }
     KMime::Message::Ptr msg = item.payload<KMime::Message::Ptr>();
 
     QColor bckColor = QApplication::palette().color(QPalette::ToolTipBase);
@@ -97,7 +113,11 @@ static QString toolTip(const Akonadi::Item &item)
         "</td>"                                                      \
         "</tr>");
 
-    QString content = MessageList::Util::contentSummary(item);
+    //Without the body (envelope only) there is nothing to preview
+    QString content;
+    if (item.loadedPayloadParts().contains(Akonadi::MessagePart::Body)) {
+        content = MessageList::Util::contentSummary(item);
+    }
 
     if (textIsLeftToRight) {
         tip += htmlCodeForStandardRow.arg(i18n("From"), msg->from()->displayString());
@@ -141,9 +161,85 @@ QString KMSearchMessageModel::fullCollectionPath(Akonadi::Collection::Id id) con
     return path;
 }
 
+void KMSearchMessageModel::fetchFullPayload(const QModelIndexList &indexes)
+{
+    for (const QModelIndex &index : indexes) {
+        const Akonadi::Item item = index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+        if (item.isValid()) {
+            requestFullPayload(item);
+        }
+    }
+}
+
+void KMSearchMessageModel::requestFullPayload(const Akonadi::Item &item) const
+{
+    if (m_fullItemCache.contains(item.id()) || m_fetchingItems.contains(item.id())) {
+        return;
+    }
+    m_pendingItems.insert(item.id());
+    if (!m_fetchTimer->isActive()) {
+        m_fetchTimer->start();
+    }
+}
+
+void KMSearchMessageModel::slotFetchPendingItems()
+{
+    Akonadi::Item::List items;
+    items.reserve(qMin(m_pendingItems.count(), s_fetchBatchSize));
+    auto it = m_pendingItems.begin();
+    while (it != m_pendingItems.end() && items.count() < s_fetchBatchSize) {
+        items.append(Akonadi::Item(*it));
+        m_fetchingItems.insert(*it);
+        it = m_pendingItems.erase(it);
+    }
+    if (items.isEmpty()) {
+        return;
+    }
+
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(items, this);
+    job->fetchScope().fetchFullPayload();
+    job->fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::None);
+    connect(job, &Akonadi::ItemFetchJob::result, this, [this, items](KJob *job) {
+        for (const Akonadi::Item &item : items) {
+            m_fetchingItems.remove(item.id());
+        }
+        slotFullPayloadFetched(job, items.count());
+    });
+
+    if (!m_pendingItems.isEmpty()) {
+        m_fetchTimer->start();
+    }
+}
+
+void KMSearchMessageModel::slotFullPayloadFetched(KJob *job, int requestedCount)
+{
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to fetch search result:" << job->errorString();
+        Q_EMIT fullPayloadFetched(requestedCount, 0);
+        return;
+    }
+
+    qint64 bytes = 0;
+    const Akonadi::Item::List items = static_cast<Akonadi::ItemFetchJob *>(job)->items();
+    for (const Akonadi::Item &item : items) {
+        bytes += item.size();
+        m_fullItemCache.insert(item.id(), new Akonadi::Item(item));
+        const QModelIndexList indexes = Akonadi::EntityTreeModel::modelIndexesForItem(this, item);
+        for (const QModelIndex &index : indexes) {
+            Q_EMIT dataChanged(index, index, {Qt::ToolTipRole});
+        }
+    }
+    Q_EMIT fullPayloadFetched(requestedCount, bytes);
+}
+
 QVariant KMSearchMessageModel::entityData(const Akonadi::Item &item, int column, int role) const
 {
     if (role == Qt::ToolTipRole) {
+        //Show the envelope right away, the preview follows once the body is fetched
+        if (const Akonadi::Item *fullItem = m_fullItemCache.object(item.id())) {
+            return toolTip(*fullItem);
+        }
+        requestFullPayload(item);
         return toolTip(item);
     }
 
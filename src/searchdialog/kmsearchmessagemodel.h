@@ -29,7 +29,13 @@
 #define KMSEARCHMESSAGEMODEL_H
 
 #include <Akonadi/KMime/MessageModel>
+#include <AkonadiCore/Item>
+#include <QCache>
 #include <QHash>
+#include <QSet>
+
+class KJob;
+class QTimer;
 
 class KMSearchMessageModel : public Akonadi::MessageModel
 {
@@ -47,6 +53,19 @@ public:
     explicit KMSearchMessageModel(Akonadi::Monitor *monitor, QObject *parent = nullptr);
     ~KMSearchMessageModel() override;
 
+    /**
+     * Results are only fetched with their envelope. Call this with the rows
+     * currently shown to load their full payloads in the background.
+     */
+    void fetchFullPayload(const QModelIndexList &indexes);
+
+Q_SIGNALS:
+    /**
+     * Emitted for every batch fetched by fetchFullPayload(), with the number of
+     * items requested and the size of the items received.
+     */
+    void fullPayloadFetched(int itemCount, qint64 bytes);
+
 protected:
     int entityColumnCount(HeaderGroup headerGroup) const override;
     QVariant entityData(const Akonadi::Item &item, int column, int role = Qt::DisplayRole) const override;
@@ -54,8 +73,16 @@ protected:
 
 private:
     Q_REQUIRED_RESULT QString fullCollectionPath(Akonadi::Collection::Id id) const;
+    void requestFullPayload(const Akonadi::Item &item) const;
+    void slotFetchPendingItems();
+    void slotFullPayloadFetched(KJob *job, int requestedCount);
 
     mutable QHash<Akonadi::Collection::Id, QString> m_collectionFullPathCache;
+    //Fully fetched messages, evicted least recently used first
+    mutable QCache<Akonadi::Item::Id, Akonadi::Item> m_fullItemCache;
+    mutable QSet<Akonadi::Item::Id> m_pendingItems;
+    QSet<Akonadi::Item::Id> m_fetchingItems;
+    QTimer *m_fetchTimer = nullptr;
 };
 
 #endif
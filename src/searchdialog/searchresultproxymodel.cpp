@@ -0,0 +1,116 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "searchresultproxymodel.h"
+
+#include <AkonadiCore/EntityTreeModel>
+
+SearchResultProxyModel::SearchResultProxyModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+}
+
+SearchResultProxyModel::~SearchResultProxyModel()
+{
+}
+
+void SearchResultProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (QAbstractItemModel *oldModel = this->sourceModel()) {
+        disconnect(oldModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &SearchResultProxyModel::slotSourceRowsAboutToBeRemoved);
+    }
+    mHiddenItems.clear();
+    mPopulated = false;
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+    if (sourceModel) {
+        connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &SearchResultProxyModel::slotSourceRowsAboutToBeRemoved);
+    }
+}
+
+void SearchResultProxyModel::setPopulated()
+{
+    if (mPopulated) {
+        return;
+    }
+    mPopulated = true;
+    if (mSearching) {
+        //Whatever was loaded so far is the content of the previous search
+        hideSourceRows();
+    }
+    invalidateFilter();
+}
+
+void SearchResultProxyModel::startSearch()
+{
+    mSearching = true;
+    if (mPopulated) {
+        hideSourceRows();
+    }
+    invalidateFilter();
+}
+
+void SearchResultProxyModel::finishSearch()
+{
+    if (!mSearching) {
+        return;
+    }
+    mSearching = false;
+    mHiddenItems.clear();
+    invalidateFilter();
+}
+
+void SearchResultProxyModel::hideSourceRows()
+{
+    const QAbstractItemModel *model = sourceModel();
+    const int count = model->rowCount();
+    mHiddenItems.reserve(mHiddenItems.count() + count);
+    for (int row = 0; row < count; ++row) {
+        const Akonadi::Item::Id id = model->index(row, 0).data(Akonadi::EntityTreeModel::ItemIdRole).toLongLong();
+        if (id > 0) {
+            mHiddenItems.insert(id);
+        }
+    }
+}
+
+void SearchResultProxyModel::slotSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    //An unlinked hit is shown again if the new query links it back
+    if (mHiddenItems.isEmpty()) {
+        return;
+    }
+    for (int row = first; row <= last; ++row) {
+        mHiddenItems.remove(sourceModel()->index(row, 0, parent).data(Akonadi::EntityTreeModel::ItemIdRole).toLongLong());
+    }
+}
+
+bool SearchResultProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    if (mSearching) {
+        if (!mPopulated) {
+            return false;
+        }
+        if (!mHiddenItems.isEmpty()) {
+            const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+            if (mHiddenItems.contains(index.data(Akonadi::EntityTreeModel::ItemIdRole).toLongLong())) {
+                return false;
+            }
+        }
+    }
+    return QSortFilterProxyModel::filterAcceptsRow(sourceRow, sourceParent);
+}
@@ -0,0 +1,65 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef SEARCHRESULTPROXYMODEL_H
+#define SEARCHRESULTPROXYMODEL_H
+
+#include <QSortFilterProxyModel>
+#include <QSet>
+#include <AkonadiCore/Item>
+
+/**
+ * Sorts the results of a search folder. Before a search folder is queried
+ * again, SearchWindow has the server unlink its previous hits, and hits of the
+ * new query are linked after that. While searching, the rows which were in the
+ * folder when the search started are hidden until they are unlinked, so that
+ * the view and the match count only show the hits of the new query, as they
+ * are linked.
+ */
+class SearchResultProxyModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit SearchResultProxyModel(QObject *parent = nullptr);
+    ~SearchResultProxyModel() override;
+
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+    /** Must be called once the source model loaded the folder */
+    void setPopulated();
+
+    /** Hides the rows currently in the folder, or loaded before it is populated */
+    void startSearch();
+    /** Shows all rows again */
+    void finishSearch();
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    Q_DISABLE_COPY(SearchResultProxyModel)
+    void hideSourceRows();
+    void slotSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+
+    QSet<Akonadi::Item::Id> mHiddenItems;
+    bool mPopulated = false;
+    bool mSearching = false;
+};
+
+#endif // SEARCHRESULTPROXYMODEL_H
@@ -23,6 +23,7 @@
 
 #include "searchwindow.h"
 #include "incompleteindexdialog.h"
+#include "incompleteindexchecker.h"
 
 #include <MailCommon/FolderRequester>
 #include "kmcommands.h"
@@ -33,6 +34,7 @@
 #include "searchdescriptionattribute.h"
 #include <MailCommon/FolderTreeView>
 #include "kmsearchmessagemodel.h"
+#include "searchresultproxymodel.h"
 #include "searchpatternwarning.h"
 #include <PimCommonAkonadi/SelectMultiCollectionDialog>
 #include <PimCommon/PimUtil>
@@ -57,7 +59,6 @@
 #include <KStandardAction>
 #include <KStandardGuiItem>
 #include <KMessageBox>
-#include <AkonadiSearch/PIM/indexeditems.h>
 
 #include <QCheckBox>
 #include <QCloseEvent>
@@ -68,12 +69,22 @@
 #include <QVBoxLayout>
 #include <QDialogButtonBox>
 #include <QPushButton>
+#include <QScrollBar>
 
 using namespace KPIM;
 using namespace MailCommon;
 
 using namespace KMail;
 
+//Matches no message: a search folder is created or emptied with it before its
+//query runs, so that the result view can be attached to it first
+static Akonadi::SearchQuery emptySearchQuery()
+{
+    Akonadi::SearchQuery query;
+    query.addTerm(Akonadi::EmailSearchTerm(Akonadi::EmailSearchTerm::MessageId, QStringLiteral("<empty-search@kmail.invalid>"), Akonadi::SearchTerm::CondEqual));
+    return query;
+}
+
 SearchWindow::SearchWindow(KMMainWidget *widget, const Akonadi::Collection &collection)
     : QDialog(nullptr)
     , mKMMainWidget(widget)
@@ -139,6 +150,10 @@ SearchWindow::SearchWindow(KMMainWidget *widget, const Akonadi::Collection &coll
 
     connect(mUi.mSearchFolderEdt, &KLineEdit::textChanged, this, &SearchWindow::scheduleRename);
     connect(&mRenameTimer, &QTimer::timeout, this, &SearchWindow::renameSearchFolder);
+    mVisibleMessagesTimer.setSingleShot(true);
+    mVisibleMessagesTimer.setInterval(200);
+    connect(&mVisibleMessagesTimer, &QTimer::timeout, this, &SearchWindow::fetchVisibleMessages);
+    connect(mUi.mLbxMatches->verticalScrollBar(), &QScrollBar::valueChanged, this, &SearchWindow::scheduleFetchVisibleMessages);
     connect(mUi.mSearchFolderOpenBtn, &QPushButton::clicked, this, &SearchWindow::openSearchFolder);
 
     connect(mUi.mSearchResultOpenBtn, &QPushButton::clicked, this, &SearchWindow::slotViewSelectedMsg);
@@ -262,14 +277,21 @@ void SearchWindow::createSearchModel()
     auto monitor = new Akonadi::Monitor();
     monitor->setCollectionMonitored(mFolder);
     mResultModel = new KMSearchMessageModel(monitor, this);
+    mResultModelCollectionId = mFolder.id();
     mResultModel->setCollectionMonitored(mFolder);
     monitor->setParent(mResultModel);
-    QSortFilterProxyModel *sortproxy = new QSortFilterProxyModel(mResultModel);
+    SearchResultProxyModel *sortproxy = new SearchResultProxyModel(mResultModel);
+    mResultProxy = sortproxy;
     sortproxy->setDynamicSortFilter(true);
     sortproxy->setSortRole(Qt::EditRole);
     sortproxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
     sortproxy->setSourceModel(mResultModel);
     mUi.mLbxMatches->setModel(sortproxy);
+    connect(sortproxy, &QSortFilterProxyModel::rowsInserted, this, &SearchWindow::scheduleFetchVisibleMessages);
+    connect(sortproxy, &QSortFilterProxyModel::layoutChanged, this, &SearchWindow::scheduleFetchVisibleMessages);
+    connect(sortproxy, &QSortFilterProxyModel::rowsInserted, this, &SearchWindow::updateMatchCount);
+    connect(sortproxy, &QSortFilterProxyModel::rowsRemoved, this, &SearchWindow::updateMatchCount);
+    connect(mResultModel, &Akonadi::EntityTreeModel::collectionPopulated, sortproxy, &SearchResultProxyModel::setPopulated);
 
     mUi.mLbxMatches->setColumnWidth(0, KMailSettings::self()->collectionWidth());
     mUi.mLbxMatches->setColumnWidth(1, KMailSettings::self()->subjectWidth());
@@ -422,11 +444,8 @@ void SearchWindow::doSearch()
         mHeaderState = mUi.mLbxMatches->header()->saveState();
     }
 
-    mUi.mLbxMatches->setModel(nullptr);
-
     mSortColumn = mUi.mLbxMatches->header()->sortIndicatorSection();
     mSortOrder = mUi.mLbxMatches->header()->sortIndicatorOrder();
-    mUi.mLbxMatches->setSortingEnabled(false);
 
     if (mSearchJob) {
         mSearchJob->kill(KJob::Quietly);
@@ -496,38 +515,84 @@ void SearchWindow::doSearch()
     qCDebug(KMAIL_LOG) << mQuery.toJSON();
     mUi.mSearchFolderOpenBtn->setEnabled(true);
 
-    const QVector<qint64> unindexedCollections = checkIncompleteIndex(searchCollections, recursive);
-    if (!unindexedCollections.isEmpty()) {
-        QScopedPointer<IncompleteIndexDialog> dlg(new IncompleteIndexDialog(unindexedCollections));
-        dlg->exec();
+    if (!mIndexChecker) {
+        mIndexChecker = new IncompleteIndexChecker(this);
+        connect(mIndexChecker, &IncompleteIndexChecker::finished, this, &SearchWindow::slotIndexCheckFinished);
     }
+    mIndexChecker->start(indexCheckCollections(searchCollections, recursive));
 
+    mSearchCollections = searchCollections;
+    mSearchRecursive = recursive;
     if (!mFolder.isValid()) {
+        //The search folder is created without hits first: the view is attached
+        //to it before the query runs, so that hits show up as they are linked
         qCDebug(KMAIL_LOG) << " create new folder " << mUi.mSearchFolderEdt->text();
-        Akonadi::SearchCreateJob *searchJob = new Akonadi::SearchCreateJob(mUi.mSearchFolderEdt->text(), mQuery, this);
+        mUi.mLbxMatches->setModel(nullptr);
+        Akonadi::SearchCreateJob *searchJob = new Akonadi::SearchCreateJob(mUi.mSearchFolderEdt->text(), emptySearchQuery(), this);
         searchJob->setSearchMimeTypes(QStringList() << QStringLiteral("message/rfc822"));
         searchJob->setSearchCollections(searchCollections);
         searchJob->setRecursive(recursive);
         searchJob->setRemoteSearchEnabled(false);
         mSearchJob = searchJob;
+        connect(mSearchJob, &KJob::result, this, &SearchWindow::slotSearchFolderCreated);
     } else {
         qCDebug(KMAIL_LOG) << " use existing folder " << mFolder.id();
-        Akonadi::PersistentSearchAttribute *attribute = new Akonadi::PersistentSearchAttribute();
-        mFolder.setContentMimeTypes(QStringList() << QStringLiteral("message/rfc822"));
-        attribute->setQueryString(QString::fromLatin1(mQuery.toJSON()));
-        attribute->setQueryCollections(searchCollections);
-        attribute->setRecursive(recursive);
-        attribute->setRemoteSearchEnabled(false);
-        mFolder.addAttribute(attribute);
-        mSearchJob = new Akonadi::CollectionModifyJob(mFolder, this);
+        if (!mResultModel || mResultModelCollectionId != mFolder.id()) {
+            createSearchModel();
+        }
+        mResultProxy->startSearch();
+        mUi.mLbxMatches->setSortingEnabled(true);
+        mUi.mLbxMatches->header()->setSortIndicator(mSortColumn, mSortOrder);
+        //Have the server unlink the previous hits first: the hits of the new
+        //query, including those which matched the previous one, are then linked
+        //and shown as they come
+        modifySearchFolder(emptySearchQuery());
+        connect(mSearchJob, &KJob::result, this, &SearchWindow::slotSearchFolderCleared);
     }
 
-    connect(mSearchJob, &Akonadi::CollectionModifyJob::result, this, &SearchWindow::searchDone);
     mUi.mProgressIndicator->show();
     enableGUI();
     mUi.mStatusLbl->setText(i18n("Searching..."));
 }
 
+void SearchWindow::modifySearchFolder(const Akonadi::SearchQuery &query)
+{
+    Akonadi::PersistentSearchAttribute *attribute = new Akonadi::PersistentSearchAttribute();
+    mFolder.setContentMimeTypes(QStringList() << QStringLiteral("message/rfc822"));
+    attribute->setQueryString(QString::fromLatin1(query.toJSON()));
+    attribute->setQueryCollections(mSearchCollections);
+    attribute->setRecursive(mSearchRecursive);
+    attribute->setRemoteSearchEnabled(false);
+    mFolder.addAttribute(attribute);
+    mSearchJob = new Akonadi::CollectionModifyJob(mFolder, this);
+}
+
+void SearchWindow::slotSearchFolderCreated(KJob *job)
+{
+    if (job->error()) {
+        searchDone(job);
+        return;
+    }
+    mFolder = static_cast<Akonadi::SearchCreateJob *>(job)->createdCollection();
+    createSearchModel();
+    mResultProxy->startSearch();
+    mUi.mLbxMatches->setSortingEnabled(true);
+    mUi.mLbxMatches->header()->setSortIndicator(mSortColumn, mSortOrder);
+    modifySearchFolder(mQuery);
+    connect(mSearchJob, &KJob::result, this, &SearchWindow::searchDone);
+}
+
+void SearchWindow::slotSearchFolderCleared(KJob *job)
+{
+    if (job->error()) {
+        searchDone(job);
+        return;
+    }
+    mFolder = static_cast<Akonadi::CollectionModifyJob *>(job)->collection();
+    modifySearchFolder(mQuery);
+    connect(mSearchJob, &KJob::result, this, &SearchWindow::searchDone);
+}
+
 void SearchWindow::searchDone(KJob *job)
 {
     Q_ASSERT(job == mSearchJob);
@@ -582,7 +647,11 @@ void SearchWindow::searchDone(KJob *job)
         connect(fetch, &KJob::result, this, &SearchWindow::slotCollectionStatisticsRetrieved);
 
         mUi.mStatusLbl->setText(i18n("Search complete."));
-        createSearchModel();
+        if (!mResultModel || mResultModelCollectionId != mFolder.id()) {
+            createSearchModel();
+        } else {
+            mResultProxy->finishSearch();
+        }
 
         if (mCloseRequested) {
             close();
@@ -621,6 +690,9 @@ void SearchWindow::slotStop()
         mSearchJob = nullptr;
         mUi.mStatusLbl->setText(i18n("Search stopped."));
     }
+    if (mIndexChecker) {
+        mIndexChecker->stop();
+    }
 
     enableGUI();
 }
@@ -888,37 +960,71 @@ void SearchWindow::slotJumpToFolder()
     }
 }
 
-QVector<qint64> SearchWindow::checkIncompleteIndex(const Akonadi::Collection::List &searchCols, bool recursive)
+void SearchWindow::updateMatchCount()
+{
+    //Once the search is done the collection statistics give the final count
+    if (mSearchJob && mUi.mLbxMatches->model()) {
+        const int count = mUi.mLbxMatches->model()->rowCount();
+        mUi.mStatusLbl->setText(i18np("Searching... %1 match", "Searching... %1 matches", count));
+    }
+}
+
+void SearchWindow::scheduleFetchVisibleMessages()
+{
+    if (!mVisibleMessagesTimer.isActive()) {
+        mVisibleMessagesTimer.start();
+    }
+}
+
+void SearchWindow::fetchVisibleMessages()
+{
+    //Results only come with their envelope, load the bodies of the rows on screen
+    if (!mResultModel) {
+        return;
+    }
+    const auto proxy = qobject_cast<QSortFilterProxyModel *>(mUi.mLbxMatches->model());
+    if (!proxy) {
+        return;
+    }
+    const QRect viewportRect = mUi.mLbxMatches->viewport()->rect();
+    QModelIndex index = mUi.mLbxMatches->indexAt(viewportRect.topLeft());
+    QModelIndexList visibleIndexes;
+    while (index.isValid() && mUi.mLbxMatches->visualRect(index).top() <= viewportRect.bottom()) {
+        visibleIndexes.append(proxy->mapToSource(index));
+        index = mUi.mLbxMatches->indexBelow(index);
+    }
+    mResultModel->fetchFullPayload(visibleIndexes);
+}
+
+Akonadi::Collection::List SearchWindow::indexCheckCollections(const Akonadi::Collection::List &searchCols, bool recursive) const
 {
-    QVector<qint64> results;
-    Akonadi::Collection::List cols;
     if (recursive) {
-        cols = searchCollectionsRecursive(searchCols);
-    } else {
-        for (const Akonadi::Collection &col : searchCols) {
-            QAbstractItemModel *etm = KMKernel::self()->collectionModel();
-            const QModelIndex idx = Akonadi::EntityTreeModel::modelIndexForCollection(etm, col);
-            const Akonadi::Collection modelCol = etm->data(idx, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
-            // Only index offline IMAP collections
-            if (PimCommon::Util::isImapResource(modelCol.resource()) && !modelCol.cachePolicy().localParts().contains(QLatin1String("RFC822"))) {
-                continue;
-            } else {
-                cols.push_back(modelCol);
-            }
+        return searchCollectionsRecursive(searchCols);
+    }
+    Akonadi::Collection::List cols;
+    QAbstractItemModel *etm = KMKernel::self()->collectionModel();
+    for (const Akonadi::Collection &col : searchCols) {
+        const QModelIndex idx = Akonadi::EntityTreeModel::modelIndexForCollection(etm, col);
+        const Akonadi::Collection modelCol = etm->data(idx, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
+        // Only index offline IMAP collections
+        if (PimCommon::Util::isImapResource(modelCol.resource()) && !modelCol.cachePolicy().localParts().contains(QLatin1String("RFC822"))) {
+            continue;
+        } else {
+            cols.push_back(modelCol);
         }
     }
+    return cols;
+}
 
-    enableGUI();
-    mUi.mProgressIndicator->hide();
-    mUi.mStatusLbl->setText(i18n("Checking index status..."));
-    //Fetch collection ?
-    for (const Akonadi::Collection &col : qAsConst(cols)) {
-        const qlonglong num = KMKernel::self()->indexedItems()->indexedItems((qlonglong)col.id());
-        if (col.statistics().count() != num) {
-            results.push_back(col.id());
-        }
+void SearchWindow::slotIndexCheckFinished(const QVector<qint64> &unindexedCollections)
+{
+    if (unindexedCollections.isEmpty()) {
+        return;
     }
-    return results;
+    //The search already runs, results of reindexed folders show up as they get indexed
+    IncompleteIndexDialog *dlg = new IncompleteIndexDialog(unindexedCollections, this);
+    dlg->setAttribute(Qt::WA_DeleteOnClose);
+    dlg->show();
 }
 
 Akonadi::Collection::List SearchWindow::searchCollectionsRecursive(const Akonadi::Collection::List &cols) const
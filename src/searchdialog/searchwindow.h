@@ -38,6 +38,8 @@ class KActionMenu;
 class KJob;
 class KMMainWidget;
 class KMSearchMessageModel;
+class SearchResultProxyModel;
+class IncompleteIndexChecker;
 
 namespace PimCommon {
 class SelectMultiCollectionDialog;
@@ -149,16 +151,24 @@ private:
     void slotSelectMultipleFolders();
 
     void slotSearchCollectionsFetched(KJob *job);
+    void slotSearchFolderCreated(KJob *job);
+    void slotSearchFolderCleared(KJob *job);
+    void modifySearchFolder(const Akonadi::SearchQuery &query);
 
     void slotJumpToFolder();
+    void scheduleFetchVisibleMessages();
+    void updateMatchCount();
+    void fetchVisibleMessages();
 
 private:
     void doSearch();
-    QVector<qint64> checkIncompleteIndex(const Akonadi::Collection::List &searchCols, bool recursive);
+    Q_REQUIRED_RESULT Akonadi::Collection::List indexCheckCollections(const Akonadi::Collection::List &searchCols, bool recursive) const;
+    void slotIndexCheckFinished(const QVector<qint64> &unindexedCollections);
     Akonadi::Collection::List searchCollectionsRecursive(const Akonadi::Collection::List &cols) const;
     QPointer<PimCommon::SelectMultiCollectionDialog> mSelectMultiCollectionDialog;
     QVector<Akonadi::Collection> mCollectionId;
     Akonadi::SearchQuery mQuery;
+    QVector<Akonadi::Collection> mSearchCollections;
     Qt::SortOrder mSortOrder = Qt::AscendingOrder;
     Akonadi::Collection mFolder;
 
@@ -168,10 +178,14 @@ private:
     MailCommon::SearchPattern mSearchPattern;
 
     bool mCloseRequested = false;
+    bool mSearchRecursive = false;
     int mSortColumn = 0;
+    Akonadi::Collection::Id mResultModelCollectionId = -1;
 
     KJob *mSearchJob = nullptr;
     KMSearchMessageModel *mResultModel = nullptr;
+    SearchResultProxyModel *mResultProxy = nullptr;
+    IncompleteIndexChecker *mIndexChecker = nullptr;
     QPushButton *mSearchButton = nullptr;
 
     QAction *mReplyAction = nullptr;
@@ -186,6 +200,7 @@ private:
     QAction *mJumpToFolderAction = nullptr;
     KActionMenu *mForwardActionMenu = nullptr;
     QTimer mRenameTimer;
+    QTimer mVisibleMessagesTimer;
     QByteArray mHeaderState;
     // not owned by us
     KMMainWidget *mKMMainWidget = nullptr;
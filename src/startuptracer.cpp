@@ -0,0 +1,195 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "startuptracer.h"
+#include "kmail_debug.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+
+using namespace KMail;
+
+//After the first paint, wait at most this long for the spans still open
+static const int s_maximumSettleDelay = 60 * 1000;
+
+bool StartupTracer::s_enabled = !qEnvironmentVariableIsEmpty("KMAIL_STARTUP_TRACE");
+
+namespace {
+struct TraceSpan {
+    QByteArray name;
+    qint64 start;
+    qint64 duration;
+};
+
+struct TraceData {
+    TraceData()
+    {
+        timer.start();
+    }
+
+    qint64 now() const
+    {
+        return timer.nsecsElapsed() / 1000;
+    }
+
+    QElapsedTimer timer;
+    QHash<QByteArray, qint64> openSpans;
+    QVector<TraceSpan> spans;
+    bool firstPaintDone = false;
+    bool finishScheduled = false;
+    bool quitConnected = false;
+};
+
+Q_GLOBAL_STATIC(TraceData, s_traceData)
+
+void scheduleFinish(TraceData *data)
+{
+    if (!data->finishScheduled) {
+        data->finishScheduled = true;
+        QTimer::singleShot(0, &StartupTracer::finish);
+    }
+}
+
+//Startup is over once the first window is painted and the spans started
+//before, e.g. the Akonadi server start and the folder tree fetch, are done
+void firstPaintDone(TraceData *data)
+{
+    if (data->firstPaintDone) {
+        return;
+    }
+    data->firstPaintDone = true;
+    if (data->openSpans.isEmpty()) {
+        scheduleFinish(data);
+    } else {
+        QTimer::singleShot(s_maximumSettleDelay, &StartupTracer::finish);
+    }
+}
+
+class FirstPaintFilter : public QObject
+{
+public:
+    FirstPaintFilter(const char *name, QWidget *widget)
+        : QObject(widget)
+        , mName(name)
+    {
+        widget->installEventFilter(this);
+    }
+
+    bool eventFilter(QObject *obj, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            obj->removeEventFilter(this);
+            StartupTracer::end(mName);
+            deleteLater();
+            if (StartupTracer::isEnabled()) {
+                firstPaintDone(s_traceData());
+            }
+        }
+        return QObject::eventFilter(obj, event);
+    }
+
+private:
+    const char *const mName;
+};
+}
+
+void StartupTracer::begin(const char *name)
+{
+    if (!s_enabled) {
+        return;
+    }
+    TraceData *data = s_traceData();
+    if (!data->quitConnected && qApp) {
+        data->quitConnected = true;
+        QObject::connect(qApp, &QCoreApplication::aboutToQuit, &StartupTracer::finish);
+    }
+    data->openSpans.insert(QByteArray(name), data->now());
+}
+
+void StartupTracer::end(const char *name)
+{
+    if (!s_enabled) {
+        return;
+    }
+    TraceData *data = s_traceData();
+    const auto it = data->openSpans.find(QByteArray::fromRawData(name, qstrlen(name)));
+    if (it == data->openSpans.end()) {
+        return;
+    }
+    data->spans.append({it.key(), it.value(), data->now() - it.value()});
+    data->openSpans.erase(it);
+    if (data->firstPaintDone && data->openSpans.isEmpty()) {
+        scheduleFinish(data);
+    }
+}
+
+void StartupTracer::endOnFirstPaint(const char *name, QWidget *widget)
+{
+    if (!s_enabled) {
+        return;
+    }
+    new FirstPaintFilter(name, widget);
+}
+
+void StartupTracer::finish()
+{
+    if (!s_enabled) {
+        return;
+    }
+    s_enabled = false;
+    const TraceData *data = s_traceData();
+    for (auto it = data->openSpans.cbegin(), end = data->openSpans.cend(); it != end; ++it) {
+        qCDebug(KMAIL_LOG) << "Startup span not finished:" << it.key();
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for (const TraceSpan &span : data->spans) {
+        QJsonObject event;
+        event.insert(QStringLiteral("name"), QString::fromLatin1(span.name));
+        event.insert(QStringLiteral("cat"), QStringLiteral("startup"));
+        event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        event.insert(QStringLiteral("ts"), span.start);
+        event.insert(QStringLiteral("dur"), span.duration);
+        event.insert(QStringLiteral("pid"), pid);
+        event.insert(QStringLiteral("tid"), 0);
+        events.append(event);
+    }
+    QJsonObject trace;
+    trace.insert(QStringLiteral("traceEvents"), events);
+    trace.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+    const QString fileName = qEnvironmentVariable("KMAIL_STARTUP_TRACE");
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(KMAIL_LOG) << "Unable to write the startup trace to" << fileName << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    qCDebug(KMAIL_LOG) << "Startup trace written to" << fileName;
+}
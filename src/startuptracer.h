@@ -0,0 +1,90 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef STARTUPTRACER_H
+#define STARTUPTRACER_H
+
+class QWidget;
+
+namespace KMail {
+/**
+ * Records how long the steps of KMail's startup take when the
+ * KMAIL_STARTUP_TRACE environment variable is set to a file name. The spans
+ * are written to that file in the Chrome trace event format (open it in
+ * chrome://tracing or Perfetto) once the message list is first painted and
+ * the spans still open then are done, at most a minute later, or when KMail
+ * quits. When the variable isn't set nothing is
+ * recorded, each trace point only tests a boolean.
+ *
+ * Spans are identified by their name and must be recorded from the GUI thread.
+ */
+class StartupTracer
+{
+public:
+    static inline bool isEnabled()
+    {
+        return s_enabled;
+    }
+
+    static void begin(const char *name);
+    static void end(const char *name);
+
+    /**
+     * Ends the span @p name when @p widget is painted for the first time.
+     */
+    static void endOnFirstPaint(const char *name, QWidget *widget);
+
+    /**
+     * Writes the recorded spans and stops recording.
+     */
+    static void finish();
+
+private:
+    static bool s_enabled;
+};
+
+/**
+ * Records a span for the lifetime of the object.
+ */
+class StartupTraceScope
+{
+public:
+    explicit StartupTraceScope(const char *name)
+        : mName(StartupTracer::isEnabled() ? name : nullptr)
+    {
+        if (mName) {
+            StartupTracer::begin(mName);
+        }
+    }
+
+    ~StartupTraceScope()
+    {
+        if (mName) {
+            StartupTracer::end(mName);
+        }
+    }
+
+private:
+    StartupTraceScope(const StartupTraceScope &) = delete;
+    StartupTraceScope &operator=(const StartupTraceScope &) = delete;
+    const char *const mName;
+};
+}
+
+#endif // STARTUPTRACER_H
@@ -0,0 +1,380 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "searchbenchmark.h"
+#include "searchdialog/kmsearchmessagemodel.h"
+
+#include <MailCommon/SearchRule>
+
+#include <AkonadiCore/AgentManager>
+#include <AkonadiCore/CollectionCreateJob>
+#include <AkonadiCore/CollectionFetchJob>
+#include <AkonadiCore/CollectionDeleteJob>
+#include <AkonadiCore/CollectionModifyJob>
+#include <AkonadiCore/EntityTreeModel>
+#include <AkonadiCore/Item>
+#include <AkonadiCore/ItemCreateJob>
+#include <AkonadiCore/Monitor>
+#include <AkonadiCore/PersistentSearchAttribute>
+#include <AkonadiCore/SearchCreateJob>
+#include <AkonadiCore/TransactionSequence>
+#include <AkonadiSearch/PIM/indexeditems.h>
+
+#include <KMime/Message>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTimer>
+
+#include <iostream>
+
+using namespace MailCommon;
+
+static const int s_searchTimeout = 5 * 60 * 1000;
+//The search is considered complete when no hit was linked for this long
+//after the search job, or for the longer delay if there is no hit yet
+static const int s_searchSettleTime = 2000;
+static const int s_emptySearchSettleTime = 10000;
+//Rows SearchWindow shows, and loads the bodies of, on a typical screen
+static const int s_visibleRows = 30;
+
+//Resets the peak resident set size reported by peakMemoryKiB()
+static bool resetPeakMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile clearRefs(QStringLiteral("/proc/self/clear_refs"));
+    return clearRefs.open(QIODevice::WriteOnly) && clearRefs.write("5") == 1;
+#else
+    return false;
+#endif
+}
+
+static qint64 peakMemoryKiB()
+{
+#ifdef Q_OS_LINUX
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (status.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> lines = status.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').constFirst().toLongLong();
+            }
+        }
+    }
+#endif
+    return -1;
+}
+
+SearchBenchmark::SearchBenchmark(int messageCount, QObject *parent)
+    : QObject(parent)
+    , mMessageCount(messageCount)
+{
+}
+
+QByteArray SearchBenchmark::createMessage(int index) const
+{
+    static const char *const subjects[] = { "Invoice", "Meeting notes", "Release plan", "Holiday pictures", "Weekly report" };
+    static const char *const senders[] = { "Alice <alice@example.com>", "Bob <bob@example.com>", "Carol <carol@example.org>" };
+
+    QByteArray data = "From: " + QByteArray(senders[index % 3]) + "\n"
+                      "To: Konqui <konqui@kde.org>\n"
+                      "Date: Sun, 21 Mar 1993 23:56:48 -0800\n"
+                      "Subject: " + QByteArray(subjects[index % 5]) + ' ' + QByteArray::number(index) + "\n"
+                      "Message-ID: <" + QByteArray::number(index) + "@searchbenchmark.kde.org>\n"
+                      "MIME-Version: 1.0\n"
+                      "Content-type: text/plain; charset=us-ascii\n"
+                      "\n";
+    //Vary the body size so that fetching full payloads shows up in the numbers
+    const QByteArray paragraph = "The quick brown fox jumps over the lazy dog, the meeting is moved to Thursday.\n";
+    data += paragraph.repeated(1 + (index % 10) * 40);
+    return data;
+}
+
+QString SearchBenchmark::errorString() const
+{
+    return mErrorString;
+}
+
+bool SearchBenchmark::createCorpus()
+{
+    //Server side search only finds indexed messages
+    bool indexerFound = false;
+    const Akonadi::AgentInstance::List agents = Akonadi::AgentManager::self()->instances();
+    for (const Akonadi::AgentInstance &agent : agents) {
+        if (agent.type().identifier() == QLatin1String("akonadi_indexing_agent")) {
+            indexerFound = true;
+            break;
+        }
+    }
+    if (!indexerFound) {
+        mErrorString = QStringLiteral("No indexing agent running, use src/tests/searchbenchmarkenv/config.xml");
+        return false;
+    }
+
+    Akonadi::CollectionFetchJob *fetchJob = new Akonadi::CollectionFetchJob(Akonadi::Collection::root(), Akonadi::CollectionFetchJob::FirstLevel);
+    if (!fetchJob->exec() || fetchJob->collections().isEmpty()) {
+        mErrorString = QStringLiteral("No resource found, run this inside akonaditest");
+        return false;
+    }
+
+    Akonadi::Collection collection;
+    collection.setParentCollection(fetchJob->collections().constFirst());
+    collection.setName(QStringLiteral("searchbenchmark"));
+    collection.setContentMimeTypes({KMime::Message::mimeType()});
+    Akonadi::CollectionCreateJob *createJob = new Akonadi::CollectionCreateJob(collection);
+    if (!createJob->exec()) {
+        mErrorString = QStringLiteral("Unable to create the corpus folder: ") + createJob->errorString();
+        return false;
+    }
+    mCorpusCollection = createJob->collection();
+
+    Akonadi::TransactionSequence *transaction = new Akonadi::TransactionSequence;
+    for (int i = 0; i < mMessageCount; ++i) {
+        KMime::Message::Ptr msg(new KMime::Message);
+        msg->setContent(createMessage(i));
+        msg->parse();
+        Akonadi::Item item;
+        item.setMimeType(KMime::Message::mimeType());
+        item.setPayload<KMime::Message::Ptr>(msg);
+        new Akonadi::ItemCreateJob(item, mCorpusCollection, transaction);
+    }
+    if (!transaction->exec()) {
+        mErrorString = QStringLiteral("Unable to create the corpus: ") + transaction->errorString();
+        return false;
+    }
+    return waitForIndexing(600);
+}
+
+bool SearchBenchmark::waitForIndexing(int timeoutSeconds)
+{
+    Akonadi::Search::PIM::IndexedItems indexedItems;
+    for (int i = 0; i < timeoutSeconds; ++i) {
+        if (indexedItems.indexedItems(mCorpusCollection.id()) >= mMessageCount) {
+            return true;
+        }
+        QEventLoop loop;
+        QTimer::singleShot(1000, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    mErrorString = QStringLiteral("Corpus was not indexed in time");
+    return false;
+}
+
+QJsonObject SearchBenchmark::runSearch(const QString &name, const SearchPattern &pattern)
+{
+    QJsonObject result;
+    result.insert(QStringLiteral("name"), name);
+
+    Akonadi::SearchQuery query;
+    if (pattern.asAkonadiQuery(query) != SearchPattern::NoError) {
+        result.insert(QStringLiteral("error"), QStringLiteral("invalid pattern"));
+        return result;
+    }
+
+    const bool peakMemoryReset = resetPeakMemory();
+
+    //Same as SearchWindow: the search collection is created without hits and
+    //shown through KMSearchMessageModel before its query runs
+    Akonadi::Collection searchCollection;
+    KMSearchMessageModel *model = nullptr;
+    {
+        Akonadi::SearchQuery emptyQuery;
+        emptyQuery.addTerm(Akonadi::EmailSearchTerm(Akonadi::EmailSearchTerm::MessageId, QStringLiteral("<empty-search@kmail.invalid>"), Akonadi::SearchTerm::CondEqual));
+        Akonadi::SearchCreateJob *createJob = new Akonadi::SearchCreateJob(QStringLiteral("searchbenchmark-") + name, emptyQuery);
+        createJob->setSearchMimeTypes({KMime::Message::mimeType()});
+        createJob->setSearchCollections({mCorpusCollection});
+        createJob->setRemoteSearchEnabled(false);
+        if (!createJob->exec()) {
+            result.insert(QStringLiteral("error"), createJob->errorString());
+            return result;
+        }
+        searchCollection = createJob->createdCollection();
+
+        Akonadi::Monitor *monitor = new Akonadi::Monitor();
+        monitor->setCollectionMonitored(searchCollection);
+        model = new KMSearchMessageModel(monitor);
+        model->setCollectionMonitored(searchCollection);
+        monitor->setParent(model);
+        QEventLoop populateLoop;
+        QTimer::singleShot(s_searchTimeout, &populateLoop, &QEventLoop::quit);
+        connect(model, &Akonadi::EntityTreeModel::collectionPopulated, &populateLoop, &QEventLoop::quit);
+        populateLoop.exec();
+    }
+
+    QElapsedTimer timer;
+    qint64 firstResult = -1;
+    qint64 lastResult = -1;
+    qint64 searchDone = -1;
+    QEventLoop loop;
+    QTimer::singleShot(s_searchTimeout, &loop, &QEventLoop::quit);
+    QTimer settleTimer;
+    settleTimer.setSingleShot(true);
+    connect(&settleTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    connect(model, &QAbstractItemModel::rowsInserted, &loop, [&]() {
+        lastResult = timer.elapsed();
+        if (firstResult < 0) {
+            firstResult = lastResult;
+        }
+        if (searchDone >= 0) {
+            settleTimer.start(s_searchSettleTime);
+        }
+    });
+
+    Akonadi::PersistentSearchAttribute *attribute = searchCollection.attribute<Akonadi::PersistentSearchAttribute>(Akonadi::Collection::AddIfMissing);
+    attribute->setQueryString(QString::fromLatin1(query.toJSON()));
+    attribute->setQueryCollections({mCorpusCollection});
+    attribute->setRemoteSearchEnabled(false);
+    timer.start();
+    Akonadi::CollectionModifyJob *searchJob = new Akonadi::CollectionModifyJob(searchCollection);
+    connect(searchJob, &KJob::result, &loop, [&](KJob *job) {
+        searchDone = timer.elapsed();
+        if (job->error()) {
+            result.insert(QStringLiteral("error"), job->errorString());
+            loop.quit();
+            return;
+        }
+        //Hits may still be linked after the job is done
+        settleTimer.start(firstResult < 0 ? s_emptySearchSettleTime : s_searchSettleTime);
+    });
+    loop.exec();
+
+    //The results are loaded envelope only: this is the size of what the model holds
+    qint64 envelopeBytes = 0;
+    qint64 fullPayloadBytes = 0;
+    qint64 fullPayloadMs = -1;
+    const int hits = model->rowCount();
+    QModelIndexList visibleIndexes;
+    for (int row = 0; row < hits; ++row) {
+        const QModelIndex index = model->index(row, 0);
+        const Akonadi::Item item = index.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+        if (item.hasPayload<KMime::Message::Ptr>()) {
+            envelopeBytes += item.payload<KMime::Message::Ptr>()->encodedContent().size();
+        }
+        if (row < s_visibleRows) {
+            visibleIndexes.append(index);
+        }
+    }
+
+    //Then the full payloads of the rows on screen are fetched, as SearchWindow does
+    if (!visibleIndexes.isEmpty()) {
+        int fetchedCount = 0;
+        QEventLoop fetchLoop;
+        QTimer::singleShot(s_searchTimeout, &fetchLoop, &QEventLoop::quit);
+        connect(model, &KMSearchMessageModel::fullPayloadFetched, &fetchLoop, [&](int itemCount, qint64 bytes) {
+            fetchedCount += itemCount;
+            fullPayloadBytes += bytes;
+            if (fetchedCount >= visibleIndexes.count()) {
+                fetchLoop.quit();
+            }
+        });
+        QElapsedTimer fetchTimer;
+        fetchTimer.start();
+        model->fetchFullPayload(visibleIndexes);
+        fetchLoop.exec();
+        fullPayloadMs = fetchTimer.elapsed();
+    }
+    delete model;
+    if (searchCollection.isValid()) {
+        Akonadi::CollectionDeleteJob *deleteJob = new Akonadi::CollectionDeleteJob(searchCollection);
+        deleteJob->exec();
+    }
+
+    result.insert(QStringLiteral("hits"), hits);
+    result.insert(QStringLiteral("timeToFirstResultMs"), firstResult);
+    result.insert(QStringLiteral("searchJobMs"), searchDone);
+    result.insert(QStringLiteral("timeToLastResultMs"), lastResult);
+    result.insert(QStringLiteral("envelopeBytesLoaded"), envelopeBytes);
+    result.insert(QStringLiteral("fullPayloadBytesFetched"), fullPayloadBytes);
+    result.insert(QStringLiteral("fullPayloadFetchMs"), fullPayloadMs);
+    //The high-water mark covers the whole process unless it could be reset
+    if (peakMemoryReset) {
+        result.insert(QStringLiteral("peakMemoryKiB"), peakMemoryKiB());
+    }
+    return result;
+}
+
+static SearchPattern createPattern(const QList<SearchRule::Ptr> &rules, SearchPattern::Operator op = SearchPattern::OpAnd)
+{
+    SearchPattern pattern;
+    pattern.setOp(op);
+    for (const SearchRule::Ptr &rule : rules) {
+        pattern.append(rule);
+    }
+    return pattern;
+}
+
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption(QStringLiteral("messages"), QStringLiteral("Number of messages in the corpus"), QStringLiteral("count"), QStringLiteral("2000")));
+    parser.addOption(QCommandLineOption(QStringLiteral("output"), QStringLiteral("Write the JSON report to this file instead of stdout"), QStringLiteral("file")));
+    parser.process(app);
+
+    const int messageCount = parser.value(QStringLiteral("messages")).toInt();
+    const QString output = parser.value(QStringLiteral("output"));
+    SearchBenchmark benchmark(messageCount);
+    const bool corpusCreated = benchmark.createCorpus();
+
+    QJsonArray searches;
+    if (corpusCreated) {
+        searches.append(benchmark.runSearch(QStringLiteral("subject"),
+                                            createPattern({SearchRule::createInstance("subject", SearchRule::FuncContains, QStringLiteral("invoice"))})));
+        searches.append(benchmark.runSearch(QStringLiteral("from"),
+                                            createPattern({SearchRule::createInstance("from", SearchRule::FuncContains, QStringLiteral("alice"))})));
+        searches.append(benchmark.runSearch(QStringLiteral("body"),
+                                            createPattern({SearchRule::createInstance("<body>", SearchRule::FuncContains, QStringLiteral("thursday"))})));
+        searches.append(benchmark.runSearch(QStringLiteral("subjectAndFrom"),
+                                            createPattern({SearchRule::createInstance("subject", SearchRule::FuncContains, QStringLiteral("meeting")),
+                                                           SearchRule::createInstance("from", SearchRule::FuncContains, QStringLiteral("bob"))})));
+        searches.append(benchmark.runSearch(QStringLiteral("subjectOrFrom"),
+                                            createPattern({SearchRule::createInstance("subject", SearchRule::FuncContains, QStringLiteral("report")),
+                                                           SearchRule::createInstance("from", SearchRule::FuncContains, QStringLiteral("carol"))},
+                                                          SearchPattern::OpOr)));
+    }
+
+    QJsonObject report;
+    report.insert(QStringLiteral("messages"), messageCount);
+    report.insert(QStringLiteral("searches"), searches);
+    //Peak of the whole run, corpus creation included
+    report.insert(QStringLiteral("processPeakMemoryKiB"), peakMemoryKiB());
+    if (!corpusCreated) {
+        qWarning() << benchmark.errorString();
+        report.insert(QStringLiteral("error"), benchmark.errorString());
+    }
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (output.isEmpty()) {
+        std::cout << json.constData();
+    } else {
+        QFile file(output);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "Unable to write" << output;
+            return 1;
+        }
+        file.write(json);
+    }
+    return corpusCreated ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef SEARCHBENCHMARK_H
+#define SEARCHBENCHMARK_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <AkonadiCore/Collection>
+#include <MailCommon/SearchPattern>
+
+/**
+ * Headless search benchmark. Meant to run inside the isolated Akonadi
+ * environment of src/tests/searchbenchmarkenv (akonaditest), which runs the
+ * indexing agent. It fills a folder with a synthetic corpus and runs
+ * search patterns the way SearchWindow does: SearchPattern::asAkonadiQuery(),
+ * a persistent search collection and KMSearchMessageModel on top of it.
+ */
+class SearchBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchBenchmark(int messageCount, QObject *parent = nullptr);
+    ~SearchBenchmark() = default;
+
+    Q_REQUIRED_RESULT bool createCorpus();
+    Q_REQUIRED_RESULT QString errorString() const;
+    Q_REQUIRED_RESULT QJsonObject runSearch(const QString &name, const MailCommon::SearchPattern &pattern);
+
+private:
+    Q_REQUIRED_RESULT bool waitForIndexing(int timeoutSeconds);
+    Q_REQUIRED_RESULT QByteArray createMessage(int index) const;
+
+    Akonadi::Collection mCorpusCollection;
+    QString mErrorString;
+    int mMessageCount = 0;
+};
+
+#endif // SEARCHBENCHMARK_H
@@ -45,13 +45,20 @@ using namespace KMail;
 UnityServiceManager::UnityServiceManager(QObject *parent)
     : QObject(parent)
     , mUnityServiceWatcher(new QDBusServiceWatcher(this))
+    , mUpdateTimer(new QTimer(this))
 {
+    //Limit tooltip and launcher updates during a busy sync
+    mUpdateTimer->setSingleShot(true);
+    mUpdateTimer->setInterval(1000);
+    connect(mUpdateTimer, &QTimer::timeout, this, &UnityServiceManager::slotUpdate);
+
     connect(kmkernel->folderCollectionMonitor(), &Akonadi::Monitor::collectionStatisticsChanged, this, &UnityServiceManager::slotCollectionStatisticsChanged);
 
-    connect(kmkernel->folderCollectionMonitor(), &Akonadi::Monitor::collectionAdded, this, &UnityServiceManager::initListOfCollection);
-    connect(kmkernel->folderCollectionMonitor(), &Akonadi::Monitor::collectionRemoved, this, &UnityServiceManager::initListOfCollection);
+    connect(kmkernel->folderCollectionMonitor(), &Akonadi::Monitor::collectionRemoved, this, &UnityServiceManager::slotCollectionRemoved);
     connect(kmkernel->folderCollectionMonitor(), &Akonadi::Monitor::collectionSubscribed, this, &UnityServiceManager::initListOfCollection);
     connect(kmkernel->folderCollectionMonitor(), &Akonadi::Monitor::collectionUnsubscribed, this, &UnityServiceManager::initListOfCollection);
+    //New folders (and folders loaded later by the model) are added one by one
+    connect(kmkernel->collectionModel(), &QAbstractItemModel::rowsInserted, this, &UnityServiceManager::slotRowsInserted);
     initListOfCollection();
     initUnity();
 }
@@ -80,30 +87,30 @@ bool UnityServiceManager::excludeFolder(const Akonadi::Collection &collection) c
     return false;
 }
 
+qint64 UnityServiceManager::unreadCount(const Akonadi::Collection &collection, const Akonadi::CollectionStatistics &statistics) const
+{
+    if (excludeFolder(collection) || ignoreNewMailInFolder(collection)) {
+        return 0;
+    }
+    return qMax(0LL, statistics.unreadCount());
+}
+
+void UnityServiceManager::addCollection(const QAbstractItemModel *model, const QModelIndex &index)
+{
+    const Akonadi::Collection collection = model->data(index, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
+    if (collection.isValid()) {
+        mUnreadCountAggregator.setUnreadCount(collection.id(), unreadCount(collection, collection.statistics()));
+    }
+    if (model->hasChildren(index)) {
+        unreadMail(model, index);
+    }
+}
+
 void UnityServiceManager::unreadMail(const QAbstractItemModel *model, const QModelIndex &parentIndex)
 {
     const int rowCount = model->rowCount(parentIndex);
     for (int row = 0; row < rowCount; ++row) {
-        const QModelIndex index = model->index(row, 0, parentIndex);
-        const Akonadi::Collection collection = model->data(index, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
-
-        if (!excludeFolder(collection)) {
-            const Akonadi::CollectionStatistics statistics = collection.statistics();
-            const qint64 count = qMax(0LL, statistics.unreadCount());
-
-            if (count > 0) {
-                if (!ignoreNewMailInFolder(collection)) {
-                    mCount += count;
-                }
-            }
-        }
-        if (model->hasChildren(index)) {
-            unreadMail(model, index);
-        }
-    }
-    if (mSystemTray) {
-        // Update tooltip to reflect count of unread messages
-        mSystemTray->updateToolTip(mCount);
+        addCollection(model, model->index(row, 0, parentIndex));
     }
 }
 
@@ -114,22 +121,49 @@ void UnityServiceManager::updateSystemTray()
 
 void UnityServiceManager::initListOfCollection()
 {
-    mCount = 0;
+    mUnreadCountAggregator.clear();
     const QAbstractItemModel *model = kmkernel->collectionModel();
     if (model->rowCount() == 0) {
         QTimer::singleShot(1000, this, &UnityServiceManager::initListOfCollection);
         return;
     }
     unreadMail(model);
-    if (mSystemTray) {
-        mSystemTray->updateStatus(mCount);
+    mUpdateTimer->stop();
+    slotUpdate();
+    Q_EMIT unreadCollectionsChanged();
+}
+
+void UnityServiceManager::updateCollection(const Akonadi::Collection &collection)
+{
+    Akonadi::Collection updatedCollection = Akonadi::EntityTreeModel::updatedCollection(kmkernel->collectionModel(), collection.id());
+    if (!updatedCollection.isValid()) {
+        updatedCollection = collection;
     }
+    if (mUnreadCountAggregator.setUnreadCount(collection.id(), unreadCount(updatedCollection, updatedCollection.statistics()))) {
+        scheduleUpdate();
+    }
+}
 
-    //qCDebug(KMAIL_LOG)<<" mCount :"<<mCount;
-    updateCount();
+void UnityServiceManager::slotRowsInserted(const QModelIndex &parent, int start, int end)
+{
+    const QAbstractItemModel *model = kmkernel->collectionModel();
+    const qint64 previousTotal = mUnreadCountAggregator.total();
+    for (int row = start; row <= end; ++row) {
+        addCollection(model, model->index(row, 0, parent));
+    }
+    if (previousTotal != mUnreadCountAggregator.total()) {
+        scheduleUpdate();
+    }
 }
 
-void UnityServiceManager::slotCollectionStatisticsChanged(Akonadi::Collection::Id id, const Akonadi::CollectionStatistics &)
+void UnityServiceManager::slotCollectionRemoved(const Akonadi::Collection &collection)
+{
+    if (mUnreadCountAggregator.removeCollection(collection.id())) {
+        scheduleUpdate();
+    }
+}
+
+void UnityServiceManager::slotCollectionStatisticsChanged(Akonadi::Collection::Id id, const Akonadi::CollectionStatistics &statistics)
 {
     //Exclude sent mail folder
 
@@ -140,18 +174,52 @@ void UnityServiceManager::slotCollectionStatisticsChanged(Akonadi::Collection::I
         || CommonKernel->draftsCollectionFolder().id() == id) {
         return;
     }
-    initListOfCollection();
+    //Unknown folders are excluded until the model inserts them
+    const Akonadi::Collection collection = Akonadi::EntityTreeModel::updatedCollection(kmkernel->collectionModel(), id);
+    if (mUnreadCountAggregator.setUnreadCount(id, unreadCount(collection, statistics))) {
+        scheduleUpdate();
+    }
+}
+
+void UnityServiceManager::scheduleUpdate()
+{
+    Q_EMIT unreadCollectionsChanged();
+    if (!mUpdateTimer->isActive()) {
+        mUpdateTimer->start();
+    }
+}
+
+void UnityServiceManager::slotUpdate()
+{
+    if (mSystemTray) {
+        mSystemTray->updateStatus(count());
+        // Update tooltip to reflect count of unread messages
+        mSystemTray->updateToolTip(count());
+    }
+
+    //qCDebug(KMAIL_LOG)<<" count :"<<count();
+    updateCount();
+}
+
+const QHash<Akonadi::Collection::Id, qint64> &UnityServiceManager::unreadCollections() const
+{
+    return mUnreadCountAggregator.unreadCounts();
+}
+
+int UnityServiceManager::count() const
+{
+    return static_cast<int>(mUnreadCountAggregator.total());
 }
 
 void UnityServiceManager::updateCount()
 {
     if (mSystemTray) {
-        mSystemTray->updateCount(mCount);
+        mSystemTray->updateCount(count());
     }
 
     if (mUnityServiceAvailable) {
         const QString launcherId = qApp->desktopFileName() + QLatin1String(".desktop");
-        const int unreadEmail = KMailSettings::self()->showUnreadInTaskbar() ? mCount : 0;
+        const int unreadEmail = KMailSettings::self()->showUnreadInTaskbar() ? count() : 0;
         const QVariantMap properties{
             {QStringLiteral("count-visible"), unreadEmail > 0},
             {QStringLiteral("count"), unreadEmail}
@@ -202,7 +270,7 @@ void UnityServiceManager::initUnity()
     });
 }
 
-bool UnityServiceManager::ignoreNewMailInFolder(const Akonadi::Collection &collection)
+bool UnityServiceManager::ignoreNewMailInFolder(const Akonadi::Collection &collection) const
 {
     if (collection.hasAttribute<Akonadi::NewMailNotifierAttribute>()) {
         if (collection.attribute<Akonadi::NewMailNotifierAttribute>()->ignoreNewMail()) {
@@ -219,7 +287,7 @@ bool UnityServiceManager::haveSystemTrayApplet() const
 
 bool UnityServiceManager::hasUnreadMail() const
 {
-    return mCount != 0;
+    return count() != 0;
 }
 
 bool UnityServiceManager::canQueryClose()
@@ -240,7 +308,7 @@ void UnityServiceManager::toggleSystemTray(QWidget *widget)
         if (!mSystemTray && KMailSettings::self()->systemTrayEnabled()) {
             mSystemTray = new KMail::KMSystemTray(widget);
             mSystemTray->setUnityServiceManager(this);
-            mSystemTray->initialize(mCount);
+            mSystemTray->initialize(count());
         } else if (mSystemTray && !KMailSettings::self()->systemTrayEnabled()) {
             // Get rid of system tray on user's request
             qCDebug(KMAIL_LOG) << "deleting systray";
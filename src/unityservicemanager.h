@@ -23,8 +23,10 @@
 #include <QModelIndex>
 #include <QObject>
 #include <AkonadiCore/Collection>
+#include "unreadcountaggregator.h"
 class QDBusServiceWatcher;
 class QAbstractItemModel;
+class QTimer;
 namespace KMail {
 class KMSystemTray;
 class UnityServiceManager : public QObject
@@ -40,18 +42,32 @@ public:
     Q_REQUIRED_RESULT bool canQueryClose();
     void toggleSystemTray(QWidget *parent);
     void initListOfCollection();
+    void updateCollection(const Akonadi::Collection &collection);
     Q_REQUIRED_RESULT bool excludeFolder(const Akonadi::Collection &collection) const;
-    Q_REQUIRED_RESULT bool ignoreNewMailInFolder(const Akonadi::Collection &collection);
+    Q_REQUIRED_RESULT bool ignoreNewMailInFolder(const Akonadi::Collection &collection) const;
     void updateCount();
+    Q_REQUIRED_RESULT const QHash<Akonadi::Collection::Id, qint64> &unreadCollections() const;
+
+Q_SIGNALS:
+    void unreadCollectionsChanged();
+
 private:
     Q_DISABLE_COPY(UnityServiceManager)
     void unreadMail(const QAbstractItemModel *model, const QModelIndex &parentIndex = {});
-    void slotCollectionStatisticsChanged(Akonadi::Collection::Id id, const Akonadi::CollectionStatistics &);
+    void slotCollectionStatisticsChanged(Akonadi::Collection::Id id, const Akonadi::CollectionStatistics &statistics);
+    void slotCollectionRemoved(const Akonadi::Collection &collection);
+    void slotRowsInserted(const QModelIndex &parent, int start, int end);
+    void addCollection(const QAbstractItemModel *model, const QModelIndex &index);
+    void scheduleUpdate();
+    void slotUpdate();
     void initUnity();
+    Q_REQUIRED_RESULT qint64 unreadCount(const Akonadi::Collection &collection, const Akonadi::CollectionStatistics &statistics) const;
+    Q_REQUIRED_RESULT int count() const;
     Q_REQUIRED_RESULT bool hasUnreadMail() const;
+    KMail::UnreadCountAggregator mUnreadCountAggregator;
     QDBusServiceWatcher *mUnityServiceWatcher = nullptr;
+    QTimer *mUpdateTimer = nullptr;
     KMail::KMSystemTray *mSystemTray = nullptr;
-    int mCount = 0;
     bool mUnityServiceAvailable = false;
 };
 }
@@ -0,0 +1,72 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "unreadcountaggregator.h"
+
+using namespace KMail;
+
+UnreadCountAggregator::UnreadCountAggregator()
+{
+}
+
+UnreadCountAggregator::~UnreadCountAggregator()
+{
+}
+
+bool UnreadCountAggregator::setUnreadCount(Akonadi::Collection::Id id, qint64 count)
+{
+    count = qMax(0LL, count);
+    const qint64 previousCount = mUnreadCounts.value(id, 0);
+    if (count == previousCount) {
+        return false;
+    }
+    if (count == 0) {
+        mUnreadCounts.remove(id);
+    } else {
+        mUnreadCounts.insert(id, count);
+    }
+    mTotal += count - previousCount;
+    return true;
+}
+
+bool UnreadCountAggregator::removeCollection(Akonadi::Collection::Id id)
+{
+    return setUnreadCount(id, 0);
+}
+
+void UnreadCountAggregator::clear()
+{
+    mUnreadCounts.clear();
+    mTotal = 0;
+}
+
+qint64 UnreadCountAggregator::total() const
+{
+    return mTotal;
+}
+
+qint64 UnreadCountAggregator::unreadCount(Akonadi::Collection::Id id) const
+{
+    return mUnreadCounts.value(id, 0);
+}
+
+const QHash<Akonadi::Collection::Id, qint64> &UnreadCountAggregator::unreadCounts() const
+{
+    return mUnreadCounts;
+}
@@ -0,0 +1,62 @@
+/*
+   Copyright (C) 2026 agent <agent@local>
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef UNREADCOUNTAGGREGATOR_H
+#define UNREADCOUNTAGGREGATOR_H
+
+#include <QHash>
+#include <AkonadiCore/Collection>
+
+namespace KMail {
+/**
+ * Keeps the unread count of each folder and their sum up to date from
+ * per-folder changes, so that the total never needs a walk of the folder tree.
+ * Only folders with unread messages are stored.
+ */
+class UnreadCountAggregator
+{
+public:
+    UnreadCountAggregator();
+    ~UnreadCountAggregator();
+
+    /**
+     * Sets the unread count of folder @p id.
+     * @return true if the total changed.
+     */
+    bool setUnreadCount(Akonadi::Collection::Id id, qint64 count);
+
+    /**
+     * Forgets folder @p id.
+     * @return true if the total changed.
+     */
+    bool removeCollection(Akonadi::Collection::Id id);
+
+    void clear();
+
+    Q_REQUIRED_RESULT qint64 total() const;
+    Q_REQUIRED_RESULT qint64 unreadCount(Akonadi::Collection::Id id) const;
+    Q_REQUIRED_RESULT const QHash<Akonadi::Collection::Id, qint64> &unreadCounts() const;
+
+private:
+    QHash<Akonadi::Collection::Id, qint64> mUnreadCounts;
+    qint64 mTotal = 0;
+};
+}
+
+#endif // UNREADCOUNTAGGREGATOR_H
@@ -26,6 +26,8 @@
 #include <KIdentityManagement/kidentitymanagement/identitymanager.h>
 #include <KIdentityManagement/kidentitymanagement/identity.h>
 #include <Akonadi/KMime/MessageFolderAttribute>
+#include <AkonadiCore/EntityTreeModel>
+#include <MessageList/View>
 
 using namespace MailCommon;
 
@@ -43,6 +45,40 @@ void CollectionPane::writeConfig(bool /*restoreSession*/)
     MessageList::Pane::writeConfig(!KMailSettings::self()->startSpecificFolderAtStartup());
 }
 
+Akonadi::Item::List CollectionPane::itemsAroundCurrentItem(int distance) const
+{
+    Akonadi::Item::List items;
+    const QWidget *widget = currentWidget();
+    const QTreeView *view = widget ? widget->findChild<MessageList::Core::View *>() : nullptr;
+    if (!view || !view->currentIndex().isValid()) {
+        return items;
+    }
+    QModelIndex below = view->currentIndex();
+    QModelIndex above = below;
+    int foundBelow = 0;
+    int foundAbove = 0;
+    while ((below.isValid() && foundBelow < distance) || (above.isValid() && foundAbove < distance)) {
+        if (below.isValid() && foundBelow < distance) {
+            below = view->indexBelow(below);
+            //Group headers don't carry an item
+            const Akonadi::Item item = below.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+            if (item.isValid()) {
+                items.append(item);
+                ++foundBelow;
+            }
+        }
+        if (above.isValid() && foundAbove < distance) {
+            above = view->indexAbove(above);
+            const Akonadi::Item item = above.data(Akonadi::EntityTreeModel::ItemRole).value<Akonadi::Item>();
+            if (item.isValid()) {
+                items.append(item);
+                ++foundAbove;
+            }
+        }
+    }
+    return items;
+}
+
 MessageList::StorageModel *CollectionPane::createStorageModel(QAbstractItemModel *model, QItemSelectionModel *selectionModel, QObject *parent)
 {
     return new CollectionStorageModel(model, selectionModel, parent);
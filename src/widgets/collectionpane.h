@@ -32,6 +32,12 @@ public:
 
     MessageList::StorageModel *createStorageModel(QAbstractItemModel *model, QItemSelectionModel *selectionModel, QObject *parent) override;
     void writeConfig(bool restoreSession) override;
+
+    /**
+     * Returns up to @p distance messages before and after the current one, in
+     * the order of the list (sorting, threads, groups), nearest first.
+     */
+    Q_REQUIRED_RESULT Akonadi::Item::List itemsAroundCurrentItem(int distance) const;
 };
 
 class CollectionStorageModel : public MessageList::StorageModel